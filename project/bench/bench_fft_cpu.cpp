@@ -0,0 +1,125 @@
+// CPU FFT benchmark: computeIFFT2DCPU (cached plan, SIMD radix-8 Stockham) against a naive scalar
+// radix-2 (bit reversal, then log2 N butterfly stages with cos/sin per butterfly) on one core, plus
+// each one's largest deviation from the same radix-2 in double precision, relative to the largest
+// output magnitude.
+// Usage: bench_fft_cpu [repeats=5] [sizes...=256 512 1024 2048]
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <vector>
+
+#include "fft_cpu.h"
+
+template <typename T>
+struct ComplexT
+{
+    T x, y;
+};
+
+// In-place inverse radix-2 of n points spaced stride apart, twiddles from cos/sin per butterfly
+template <typename T>
+static void radix2(ComplexT<T> *data, int n, int stride)
+{
+    for (int i = 1, j = 0; i < n; ++i)
+    {
+        int bit = n >> 1;
+        for (; j & bit; bit >>= 1)
+            j ^= bit;
+        j ^= bit;
+        if (i < j)
+            std::swap(data[i * stride], data[j * stride]);
+    }
+    for (int len = 2; len <= n; len <<= 1)
+    {
+        for (int start = 0; start < n; start += len)
+        {
+            for (int k = 0; k < len / 2; ++k)
+            {
+                const T angle = static_cast<T>(2.0 * M_PI) * k / len;
+                const T wr = std::cos(angle), wi = std::sin(angle);
+                ComplexT<T> &a = data[(start + k) * stride];
+                ComplexT<T> &b = data[(start + k + len / 2) * stride];
+                const ComplexT<T> t = {b.x * wr - b.y * wi, b.x * wi + b.y * wr};
+                b = {a.x - t.x, a.y - t.y};
+                a = {a.x + t.x, a.y + t.y};
+            }
+        }
+    }
+}
+
+// Rows, then columns, same contract as computeIFFT2DCPU (row-major, un-normalized)
+template <typename T>
+static void naiveIFFT2D(const Complex *spectrum, ComplexT<T> *out, int N)
+{
+    for (size_t i = 0; i < static_cast<size_t>(N) * N; ++i)
+        out[i] = {spectrum[i].x, spectrum[i].y};
+    for (int row = 0; row < N; ++row)
+        radix2(out + static_cast<size_t>(row) * N, N, 1);
+    for (int column = 0; column < N; ++column)
+        radix2(out + column, N, N);
+}
+
+template <typename C>
+static double maxRelativeError(const std::vector<C> &values, const std::vector<ComplexT<double>> &reference)
+{
+    double peak = 0.0, error = 0.0;
+    for (size_t i = 0; i < reference.size(); ++i)
+    {
+        peak = std::max(peak, std::hypot(reference[i].x, reference[i].y));
+        error = std::max(error, std::hypot(values[i].x - reference[i].x, values[i].y - reference[i].y));
+    }
+    return peak > 0.0 ? error / peak : error;
+}
+
+template <typename F>
+static double bestSeconds(int repeats, F run)
+{
+    using namespace std::chrono;
+    double best = 1e30;
+    for (int r = 0; r < repeats; ++r)
+    {
+        auto start = steady_clock::now();
+        run();
+        best = std::min(best, duration<double>(steady_clock::now() - start).count());
+    }
+    return best;
+}
+
+int main(int argc, char *argv[])
+{
+    const int repeats = argc > 1 ? atoi(argv[1]) : 5;
+    std::vector<int> sizes;
+    for (int i = 2; i < argc; ++i)
+        sizes.push_back(atoi(argv[i]));
+    if (sizes.empty())
+        sizes = {256, 512, 1024, 2048};
+    if (repeats < 1)
+        return 1;
+
+    printf("%6s %12s %12s %8s %12s %12s\n", "N", "radix-2 ms", "plan ms", "speedup", "err radix-2", "err plan");
+    for (int N : sizes)
+    {
+        const size_t size = static_cast<size_t>(N) * N;
+        std::vector<Complex> spectrum(size), planned(size);
+        std::mt19937 rng(1234);
+        std::normal_distribution<float> gauss;
+        for (Complex &c : spectrum)
+            c = {gauss(rng), gauss(rng)};
+
+        std::vector<ComplexT<double>> reference(size);
+        std::vector<ComplexT<float>> scalar(size);
+        naiveIFFT2D(spectrum.data(), reference.data(), N);
+
+        if (!computeIFFT2DCPU(spectrum.data(), planned.data(), N, N)) // builds the cached plan
+            return 1;
+        double scalarSeconds = bestSeconds(repeats, [&] { naiveIFFT2D(spectrum.data(), scalar.data(), N); });
+        double planSeconds = bestSeconds(repeats, [&] { computeIFFT2DCPU(spectrum.data(), planned.data(), N, N); });
+
+        printf("%6d %12.3f %12.3f %7.1fx %12.2e %12.2e\n", N, scalarSeconds * 1e3, planSeconds * 1e3,
+               scalarSeconds / planSeconds, maxRelativeError(scalar, reference), maxRelativeError(planned, reference));
+    }
+    return 0;
+}
@@ -0,0 +1,122 @@
+// GPU FFT benchmark: the batched complex-to-real inverse transform used by the ocean (kSpecCount
+// half spectra per call) with the per-length twiddle/index tables against cos/sin per butterfly,
+// plus each path's largest deviation from the CPU FFT relative to the largest output value.
+// Usage: bench_fft_gpu [repeats=20] [sizes...=256 512 1024]
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <vector>
+
+#include "fft_cpu.h"
+#include "fft_gpu.h"
+#include "headless_gl.h"
+
+static const int kBatch = 5; // spectra per ocean frame
+
+// Random half spectra that are Hermitian where the C2R layout stores both k and -k (kx = 0 and
+// kx = N/2 columns), so GPU and CPU transforms agree.
+static void makeHalfSpectra(int N, std::vector<Complex> &spectra)
+{
+    const int bins = N / 2 + 1;
+    std::mt19937 rng(1234);
+    std::normal_distribution<float> gauss;
+    for (Complex &c : spectra)
+        c = {gauss(rng), gauss(rng)};
+    for (int f = 0; f < kBatch; ++f)
+    {
+        Complex *field = spectra.data() + static_cast<size_t>(f) * N * bins;
+        for (int u : {0, N / 2})
+        {
+            for (int v = 0; v <= N / 2; ++v)
+            {
+                Complex &a = field[v * bins + u];
+                Complex &b = field[((N - v) % N) * bins + u];
+                if (v == 0 || v == N / 2)
+                    a.y = 0.0f;
+                else
+                    b = {a.x, -a.y};
+            }
+        }
+    }
+}
+
+static double runGPU(FFTPlanGPU *plan, GLuint input, int repeats, size_t outputSize, std::vector<float> &out)
+{
+    using namespace std::chrono;
+    GLuint result = executeIFFT2DC2RBatchGPU(plan, input, kBatch); // warm-up
+    glFinish();
+    double best = 1e30;
+    for (int r = 0; r < repeats; ++r)
+    {
+        auto start = steady_clock::now();
+        result = executeIFFT2DC2RBatchGPU(plan, input, kBatch);
+        glFinish();
+        best = std::min(best, duration<double>(steady_clock::now() - start).count());
+    }
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, result);
+    glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(float) * outputSize, out.data());
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+    return best;
+}
+
+static double maxRelativeError(const std::vector<float> &values, const std::vector<float> &reference)
+{
+    double peak = 0.0, error = 0.0;
+    for (size_t i = 0; i < reference.size(); ++i)
+    {
+        peak = std::max(peak, (double)fabsf(reference[i]));
+        error = std::max(error, (double)fabsf(values[i] - reference[i]));
+    }
+    return peak > 0.0 ? error / peak : error;
+}
+
+int main(int argc, char *argv[])
+{
+    const int repeats = argc > 1 ? atoi(argv[1]) : 20;
+    std::vector<int> sizes;
+    for (int i = 2; i < argc; ++i)
+        sizes.push_back(atoi(argv[i]));
+    if (sizes.empty())
+        sizes = {256, 512, 1024};
+    if (repeats < 1 || !HeadlessGL_Init(4, 3))
+        return 1;
+
+    printf("%6s %14s %14s %8s %12s %12s\n", "N", "cos/sin ms", "tables ms", "speedup", "err cos/sin", "err tables");
+    for (int N : sizes)
+    {
+        FFTPlanGPU *plan = createFFTPlanGPU(N, N, kBatch, true);
+        FFTPlanCPU *cpuPlan = createFFTPlanCPU(N, N);
+        if (!plan || !cpuPlan)
+            return 1;
+
+        const size_t halfSize = static_cast<size_t>(N) * (N / 2 + 1) * kBatch;
+        const size_t outputSize = static_cast<size_t>(N) * N * kBatch;
+        std::vector<Complex> spectra(halfSize);
+        makeHalfSpectra(N, spectra);
+
+        GLuint input = 0;
+        glGenBuffers(1, &input);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, input);
+        glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(Complex) * halfSize, spectra.data(), GL_STATIC_DRAW);
+
+        std::vector<float> reference(outputSize), direct(outputSize), tables(outputSize);
+        std::vector<Complex> scratch = spectra;
+        executeIFFT2DC2RBatchCPU(cpuPlan, scratch.data(), reference.data(), kBatch, nullptr);
+
+        setFFTTablesEnabledGPU(false);
+        double directSeconds = runGPU(plan, input, repeats, outputSize, direct);
+        setFFTTablesEnabledGPU(true);
+        double tableSeconds = runGPU(plan, input, repeats, outputSize, tables);
+
+        printf("%6d %14.3f %14.3f %7.2fx %12.2e %12.2e\n", N, directSeconds * 1e3, tableSeconds * 1e3,
+               directSeconds / tableSeconds, maxRelativeError(direct, reference), maxRelativeError(tables, reference));
+
+        glDeleteBuffers(1, &input);
+        destroyFFTPlanCPU(cpuPlan);
+        destroyFFTPlanGPU(plan);
+    }
+    return 0;
+}
@@ -0,0 +1,207 @@
+// Per-stage GPU timings of the ocean update (Ocean_SetStageTiming: GL_TIMESTAMP queries around
+// each stage) over a matrix of resolutions and output sets, written as JSON for regression checks.
+// Usage: bench_ocean [--frames N] [--sizes 128,256,...] [--sets separate,packed,...] [--out FILE]
+// Defaults: 30 frames, sizes 128 to 2048, every set, bench_ocean.json. On a software driver keep
+// the matrix small, e.g. LIBGL_ALWAYS_SOFTWARE=1 ./bench_ocean --frames 5 --sizes 128,256
+// Each entry holds the median and p99 (nearest rank) milliseconds of every stage, of their sum and
+// of the whole frame on the CPU clock (update plus glFinish).
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "headless_gl.h"
+#include "ocean.h"
+
+static const int kWarmupFrames = 2;
+
+static const char *kStageNames[kOceanStageCount] = {"evolve", "fft_columns", "fft_rows", "outputs"};
+
+// Output sets: which fields the outputs stage writes and how
+struct FieldSet
+{
+    const char *name;
+    OceanOutputLayout layout;
+    bool normalMap;
+    int cascades;
+    OceanPrecision precision;
+};
+static const FieldSet kFieldSets[] = {
+    {"separate", kOceanOutputSeparate, false, 1, kOceanPrecisionFull},
+    {"packed", kOceanOutputPacked, false, 1, kOceanPrecisionFull},
+    {"packed_normals", kOceanOutputPacked, true, 1, kOceanPrecisionFull},
+    {"separate_half", kOceanOutputSeparate, false, 1, kOceanPrecisionHalf},
+    {"packed_3_cascades", kOceanOutputPacked, false, 3, kOceanPrecisionFull},
+};
+
+struct BenchOptions
+{
+    int frames = 30;
+    std::vector<int> sizes = {128, 256, 512, 1024, 2048};
+    std::vector<const FieldSet *> sets;
+    const char *outPath = "bench_ocean.json";
+};
+
+// Splits a comma-separated list
+static std::vector<std::string> splitList(const char *list)
+{
+    std::vector<std::string> items;
+    std::string item;
+    for (const char *c = list;; ++c)
+    {
+        if (*c == ',' || *c == '\0')
+        {
+            if (!item.empty())
+                items.push_back(item);
+            item.clear();
+            if (*c == '\0')
+                break;
+        }
+        else
+            item += *c;
+    }
+    return items;
+}
+
+static bool parseOptions(int argc, char *argv[], BenchOptions &options)
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        const char *arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (!strcmp(arg, "--frames") && hasValue)
+            options.frames = atoi(argv[++i]);
+        else if (!strcmp(arg, "--out") && hasValue)
+            options.outPath = argv[++i];
+        else if (!strcmp(arg, "--sizes") && hasValue)
+        {
+            options.sizes.clear();
+            for (const std::string &size : splitList(argv[++i]))
+                options.sizes.push_back(atoi(size.c_str()));
+        }
+        else if (!strcmp(arg, "--sets") && hasValue)
+        {
+            for (const std::string &name : splitList(argv[++i]))
+            {
+                const FieldSet *set = nullptr;
+                for (const FieldSet &candidate : kFieldSets)
+                    if (name == candidate.name)
+                        set = &candidate;
+                if (!set)
+                {
+                    printf("Unknown set '%s'.\n", name.c_str());
+                    return false;
+                }
+                options.sets.push_back(set);
+            }
+        }
+        else
+        {
+            printf("Usage: %s [--frames N] [--sizes 128,256,...] [--sets separate,packed,...] [--out FILE]\nSets:", argv[0]);
+            for (const FieldSet &set : kFieldSets)
+                printf(" %s", set.name);
+            printf("\n");
+            return false;
+        }
+    }
+    if (options.sets.empty())
+        for (const FieldSet &set : kFieldSets)
+            options.sets.push_back(&set);
+    return options.frames > 0 && !options.sizes.empty();
+}
+
+// Nearest-rank percentile of an unsorted sample
+static double percentile(std::vector<double> samples, double p)
+{
+    std::sort(samples.begin(), samples.end());
+    size_t rank = static_cast<size_t>(p / 100.0 * samples.size() + 0.999999);
+    return samples[std::min(std::max<size_t>(rank, 1), samples.size()) - 1];
+}
+
+static void writeStat(FILE *file, const char *name, const std::vector<double> &samples, bool last)
+{
+    fprintf(file, "        \"%s\": {\"median_ms\": %.4f, \"p99_ms\": %.4f}%s\n", name, percentile(samples, 50.0),
+            percentile(samples, 99.0), last ? "" : ",");
+}
+
+int main(int argc, char *argv[])
+{
+    BenchOptions options;
+    if (!parseOptions(argc, argv, options) || !HeadlessGL_Init(4, 3))
+        return 1;
+    FILE *file = fopen(options.outPath, "w");
+    if (!file)
+    {
+        printf("Could not open %s for writing.\n", options.outPath);
+        return 1;
+    }
+
+    fprintf(file, "{\n  \"renderer\": \"%s\",\n  \"frames\": %d,\n  \"results\": [\n",
+            (const char *)glGetString(GL_RENDERER), options.frames);
+    Ocean_SetStageTiming(true);
+    bool first = true;
+    for (int size : options.sizes)
+    {
+        for (const FieldSet *set : options.sets)
+        {
+            OceanInitParams params;
+            params.resolution = size;
+            params.outputLayout = set->layout;
+            params.normalMap = set->normalMap;
+            params.cascadeCount = set->cascades;
+            params.precision = set->precision;
+            Ocean_Init(params);
+            for (int frame = 0; frame < kWarmupFrames; ++frame)
+                Ocean_UpdateAtTime(frame / 60.0f);
+            glFinish();
+
+            std::vector<double> stages[kOceanStageCount], gpuTotal, frameMs;
+            for (int frame = 0; frame < options.frames; ++frame)
+            {
+                using namespace std::chrono;
+                auto start = steady_clock::now();
+                Ocean_UpdateAtTime((kWarmupFrames + frame) / 60.0f);
+                glFinish();
+                frameMs.push_back(duration<double, std::milli>(steady_clock::now() - start).count());
+
+                double ms[kOceanStageCount];
+                if (!Ocean_GetStageTimes(ms))
+                {
+                    printf("No stage timings: the ocean compute pipeline did not run.\n");
+                    fclose(file);
+                    return 1;
+                }
+                double sum = 0.0;
+                for (int stage = 0; stage < kOceanStageCount; ++stage)
+                {
+                    stages[stage].push_back(ms[stage]);
+                    sum += ms[stage];
+                }
+                gpuTotal.push_back(sum);
+            }
+
+            printf("%5d %-18s gpu %9.3f ms (median), frame %9.3f ms\n", size, set->name, percentile(gpuTotal, 50.0),
+                   percentile(frameMs, 50.0));
+            fprintf(file, "%s    {\n      \"resolution\": %d,\n      \"set\": \"%s\",\n      \"stages\": {\n",
+                    first ? "" : ",\n", size, set->name);
+            for (int stage = 0; stage < kOceanStageCount; ++stage)
+                writeStat(file, kStageNames[stage], stages[stage], false);
+            writeStat(file, "gpu_total", gpuTotal, false);
+            writeStat(file, "frame", frameMs, true);
+            fprintf(file, "      }\n    }");
+            first = false;
+        }
+    }
+    fprintf(file, "\n  ]\n}\n");
+    fclose(file);
+
+    GLenum glError = glGetError();
+    if (glError != GL_NO_ERROR)
+        printf("GL error 0x%x.\n", glError);
+    Ocean_Shutdown();
+    HeadlessGL_Shutdown();
+    return glError == GL_NO_ERROR ? 0 : 1;
+}
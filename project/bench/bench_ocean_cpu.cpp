@@ -0,0 +1,75 @@
+// Thread scaling benchmark for the CPU ocean pipeline.
+// Usage: bench_ocean_cpu [resolution=512] [frames=20] [patches=1] [maxThreads=hardware]
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include "ocean_cpu.h"
+#include "thread_pool.h"
+
+static double runFrames(std::vector<OceanCPU *> &patches, int frames)
+{
+    using namespace std::chrono;
+    const float dt = 1.0f / 60.0f;
+    for (OceanCPU *patch : patches) // warm-up (page faults, plan scratch)
+        OceanCPU_Update(patch, 0.0f);
+
+    auto start = steady_clock::now();
+    for (int frame = 0; frame < frames; ++frame)
+    {
+        for (OceanCPU *patch : patches)
+            OceanCPU_Update(patch, frame * dt);
+    }
+    return duration<double>(steady_clock::now() - start).count();
+}
+
+int main(int argc, char *argv[])
+{
+    const int resolution = argc > 1 ? atoi(argv[1]) : 512;
+    const int frames = argc > 2 ? atoi(argv[2]) : 20;
+    const int patchCount = argc > 3 ? atoi(argv[3]) : 1;
+    int maxThreads = argc > 4 ? atoi(argv[4]) : static_cast<int>(std::thread::hardware_concurrency());
+    if (maxThreads < 1)
+        maxThreads = 1;
+
+    std::vector<int> threadCounts;
+    for (int threads = 1; threads < maxThreads; threads *= 2)
+        threadCounts.push_back(threads);
+    threadCounts.push_back(maxThreads);
+
+    OceanInitParams params;
+    params.resolution = resolution;
+
+    printf("CPU ocean pipeline: %dx%d, %d patch(es), %d frames\n", resolution, resolution, patchCount, frames);
+    printf("%8s %12s %12s %10s %11s\n", "threads", "ms/frame", "patches/s", "speedup", "efficiency");
+
+    double baseline = 0.0;
+    for (int threads : threadCounts)
+    {
+        ThreadPool *pool = ThreadPool_Create(threads);
+        std::vector<OceanCPU *> patches;
+        for (int i = 0; i < patchCount; ++i)
+        {
+            params.randomSeed = 132234u + i;
+            OceanCPU *patch = OceanCPU_Create(params, pool);
+            if (!patch)
+                return 1;
+            patches.push_back(patch);
+        }
+
+        double seconds = runFrames(patches, frames);
+        double msPerFrame = 1000.0 * seconds / frames;
+        double patchesPerSecond = frames * patchCount / seconds;
+        if (threads == 1)
+            baseline = msPerFrame;
+        double speedup = baseline / msPerFrame;
+        printf("%8d %12.3f %12.1f %9.2fx %10.0f%%\n", threads, msPerFrame, patchesPerSecond, speedup, 100.0 * speedup / threads);
+
+        for (OceanCPU *patch : patches)
+            OceanCPU_Destroy(patch);
+        ThreadPool_Destroy(pool);
+    }
+    return 0;
+}
@@ -0,0 +1,149 @@
+// Reports what kOceanPrecisionHalf gives up against the fp32 GPU pipeline, e.g. on llvmpipe:
+// LIBGL_ALWAYS_SOFTWARE=1 ./validate_ocean_precision [resolution=256] [frames=8]
+// Each case (fixed seeds) simulates the same frames in both modes and compares height,
+// displacement and Jacobian of every cascade: max and RMS error relative to the fp32 field's peak
+// in that cascade. It also prints the buffer and texture bytes
+// each mode moves per frame and the simulation time per frame (readback excluded); the time only
+// means something on a hardware driver, a software one does not pay for memory bandwidth.
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <algorithm>
+#include <chrono>
+#include <vector>
+
+#include "headless_gl.h"
+#include "ocean.h"
+
+static const float kFrameStep = 0.5f; // seconds between compared frames
+
+static const OceanField kFields[] = {kOceanFieldHeight, kOceanFieldDispX, kOceanFieldDispZ, kOceanFieldJacobian};
+static const char *kFieldNames[] = {"height", "dispX", "dispZ", "jacobian"};
+static const int kFieldCount = sizeof(kFields) / sizeof(kFields[0]);
+
+// Bytes the GPU buffers and textures move per frame, from their sizes: each stage reads its
+// inputs and writes its outputs once (one shared-memory pass per FFT axis, N <= 2048). Lookup
+// tables and the jacobian's halo reads are left out.
+static double bytesPerFrame(const OceanInitParams &params)
+{
+    const bool half = params.precision == kOceanPrecisionHalf;
+    const double N = params.resolution;
+    const double bins = N * (N / 2 + 1) * params.cascadeCount; // half-spectrum bins, all cascades
+    const double texels = N * N * params.cascadeCount;
+    const double spectra = 5.0;                                  // height, slopes, displacements
+    const double complexBytes = half ? 4.0 : 8.0;
+    const double realBytes = half ? 2.0 : 4.0;
+
+    double evolve = bins * (16.0 + 4.0) + spectra * bins * complexBytes; // H0 pairs and omega in
+    double fftColumns = 2.0 * spectra * bins * complexBytes;
+    double fftRows = spectra * bins * complexBytes + spectra * texels * realBytes;
+    double textures = params.outputLayout == kOceanOutputPacked ? 2.0 * 4.0 * texels * realBytes
+                                                                : 6.0 * texels * realBytes;
+    double outputs = spectra * texels * realBytes + textures;
+    return evolve + fftColumns + fftRows + outputs;
+}
+
+// Simulates `frames` frames and returns the compared fields of each cascade, frame-major then
+// cascade-major.
+static std::vector<float> simulate(const OceanInitParams &params, int frames, double &msPerFrame)
+{
+    Ocean_SetParams(params);
+    const int cascades = params.cascadeCount;
+    const size_t fieldSize = static_cast<size_t>(params.resolution) * params.resolution;
+    std::vector<float> fields(fieldSize * kFieldCount * cascades * frames);
+
+    Ocean_UpdateAtTime(0.0f); // warm-up
+    glFinish();
+    double seconds = 0.0;
+    for (int frame = 0; frame < frames; ++frame)
+    {
+        using namespace std::chrono;
+        auto start = steady_clock::now();
+        Ocean_UpdateAtTime(frame * kFrameStep);
+        glFinish();
+        seconds += duration<double>(steady_clock::now() - start).count();
+
+        for (int c = 0; c < cascades; ++c)
+            for (int f = 0; f < kFieldCount; ++f)
+                Ocean_ReadField(kFields[f],
+                                fields.data() + ((static_cast<size_t>(frame) * cascades + c) * kFieldCount + f) * fieldSize,
+                                c);
+    }
+    msPerFrame = 1000.0 * seconds / frames;
+    return fields;
+}
+
+int main(int argc, char *argv[])
+{
+    const int resolution = argc > 1 ? atoi(argv[1]) : 256;
+    const int frames = argc > 2 ? atoi(argv[2]) : 8;
+    if (frames < 1 || !HeadlessGL_Init(4, 3))
+        return 1;
+
+    OceanInitParams base;
+    base.resolution = resolution;
+    Ocean_Init(base);
+
+    struct Case
+    {
+        const char *name;
+        OceanInitParams params;
+    };
+    std::vector<Case> cases(3, {"", Ocean_GetParams()});
+    cases[0].name = "default";
+    cases[1].name = "seed 7, wind 12 m/s";
+    cases[1].params.randomSeed = 7u;
+    cases[1].params.windSpeed = 12.0f;
+    cases[2].name = "3 cascades";
+    cases[2].params.cascadeCount = 3;
+
+    const size_t fieldSize = static_cast<size_t>(resolution) * resolution;
+    printf("%-22s %-9s %12s %12s %12s %8s\n", "case", "field", "max rel", "rms rel", "peak", "cascade");
+    for (const Case &c : cases)
+    {
+        OceanInitParams full = c.params, half = c.params;
+        full.precision = kOceanPrecisionFull;
+        half.precision = kOceanPrecisionHalf;
+        double fullMs = 0.0, halfMs = 0.0;
+        std::vector<float> reference = simulate(full, frames, fullMs);
+        std::vector<float> values = simulate(half, frames, halfMs);
+        const int cascades = c.params.cascadeCount;
+
+        for (int cascade = 0; cascade < cascades; ++cascade)
+        {
+            for (int f = 0; f < kFieldCount; ++f)
+            {
+                double peak = 0.0, maxError = 0.0, sumSquares = 0.0;
+                for (int frame = 0; frame < frames; ++frame)
+                {
+                    const size_t offset = ((static_cast<size_t>(frame) * cascades + cascade) * kFieldCount + f) * fieldSize;
+                    for (size_t i = offset; i < offset + fieldSize; ++i)
+                    {
+                        double error = fabs((double)values[i] - reference[i]);
+                        peak = std::max(peak, fabs((double)reference[i]));
+                        maxError = std::max(maxError, error);
+                        sumSquares += error * error;
+                    }
+                }
+                double rms = sqrt(sumSquares / (fieldSize * frames));
+                if (peak > 0.0)
+                {
+                    maxError /= peak;
+                    rms /= peak;
+                }
+                printf("%-22s %-9s %12.3e %12.3e %12.3e %8d\n", cascade == 0 && f == 0 ? c.name : "", kFieldNames[f],
+                       maxError, rms, peak, cascade);
+            }
+        }
+        double fullBytes = bytesPerFrame(full), halfBytes = bytesPerFrame(half);
+        printf("%-22s %-9s fp32 %.2f MiB/frame, half %.2f MiB/frame (%.2fx less)\n", "", "bytes",
+               fullBytes / (1 << 20), halfBytes / (1 << 20), fullBytes / halfBytes);
+        printf("%-22s %-9s fp32 %.3f ms/frame, half %.3f ms/frame\n", "", "time", fullMs, halfMs);
+    }
+
+    GLenum glError = glGetError();
+    if (glError != GL_NO_ERROR)
+        printf("GL error 0x%x.\n", glError);
+    HeadlessGL_Shutdown();
+    return glError == GL_NO_ERROR ? 0 : 1;
+}
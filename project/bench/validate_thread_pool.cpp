@@ -0,0 +1,77 @@
+// Stress test for ThreadPool_ParallelFor: many short loops back to back, as the CPU ocean issues
+// them, each checked to run every index exactly once. A watchdog fails the run if a loop hangs.
+// Usage: validate_thread_pool [loops=200000] [threads=hardware]
+#include <stdio.h>
+#include <stdlib.h>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include "thread_pool.h"
+
+static const int kTimeoutSeconds = 10;
+
+int main(int argc, char *argv[])
+{
+    const int loops = argc > 1 ? atoi(argv[1]) : 200000;
+    const int threads = argc > 2 ? atoi(argv[2]) : 0;
+
+    std::atomic<int> progress{0};
+    std::atomic<bool> finished{false};
+    std::thread watchdog([&]
+    {
+        int last = -1, stalled = 0;
+        while (!finished.load())
+        {
+            std::this_thread::sleep_for(std::chrono::seconds(1));
+            int now = progress.load();
+            stalled = now == last ? stalled + 1 : 0;
+            last = now;
+            if (stalled >= kTimeoutSeconds)
+            {
+                printf("FAIL: no progress for %d s at loop %d.\n", kTimeoutSeconds, now);
+                fflush(stdout);
+                _Exit(1);
+            }
+        }
+    });
+
+    ThreadPool *pool = ThreadPool_Create(threads);
+    printf("%d loops on %d threads\n", loops, ThreadPool_GetThreadCount(pool));
+
+    const int maxCount = 256;
+    std::vector<std::atomic<int>> hits(maxCount);
+    int failures = 0;
+    for (int loop = 0; loop < loops && failures < 10; ++loop)
+    {
+        // Short loops with few items per chunk, so workers finish and steal right at the boundary.
+        const int count = 1 + loop % maxCount;
+        const int grain = 1 + loop % 3;
+        for (int i = 0; i < count; ++i)
+            hits[i].store(0, std::memory_order_relaxed);
+        ThreadPool_ParallelFor(pool, count, grain, [&](int begin, int end, int)
+        {
+            for (int i = begin; i < end; ++i)
+                hits[i].fetch_add(1, std::memory_order_relaxed);
+        });
+        for (int i = 0; i < count; ++i)
+        {
+            if (hits[i].load(std::memory_order_relaxed) != 1)
+            {
+                printf("FAIL: loop %d (count %d, grain %d) ran index %d %d times.\n", loop, count, grain, i,
+                       hits[i].load());
+                ++failures;
+                break;
+            }
+        }
+        progress.store(loop + 1);
+    }
+
+    ThreadPool_Destroy(pool);
+    finished.store(true);
+    watchdog.join();
+    if (failures == 0)
+        printf("PASS\n");
+    return failures == 0 ? 0 : 1;
+}
@@ -8,5 +8,8 @@ void Camera_Init();
 // Handle input and update camera per frame.
 void Camera_HandleInput(float delta);
 
+// Current camera position in world space.
+vec3 Camera_GetPosition();
+
 // Upload current view and related uniforms to shaders.
 void Camera_UpdateViewUniforms(GLuint program, GLuint waterProgram, GLuint skyboxProgram, mat4 projection);
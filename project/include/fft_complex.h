@@ -0,0 +1,8 @@
+#pragma once
+
+// Simple complex number used for FFT buffers (float2 on the GPU, interleaved re/im on the CPU).
+struct Complex
+{
+    float x;
+    float y;
+};
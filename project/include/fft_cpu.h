@@ -0,0 +1,29 @@
+#pragma once
+
+#include "fft_complex.h"
+
+struct ThreadPool;
+
+// Precomputed plan (twiddles, radix schedule, scratch) for W x H inverse FFTs on the CPU.
+struct FFTPlanCPU;
+
+// Create a plan for power-of-two W x H transforms. Returns nullptr on invalid sizes.
+FFTPlanCPU *createFFTPlanCPU(int W, int H);
+void destroyFFTPlanCPU(FFTPlanCPU *plan);
+
+// In-place 2D inverse FFT with the same contract as computeIFFT2D: row-major (kx fastest),
+// un-normalized output (divide by W*H to get original amplitudes).
+void executeIFFT2DCPU(FFTPlanCPU *plan, Complex *data);
+
+// Transforms count W x H fields stored back to back, spreading the row and column passes of all
+// fields over the pool (null pool -> calling thread). Calls on one plan must not overlap.
+void executeIFFT2DBatchCPU(FFTPlanCPU *plan, Complex *data, int count, ThreadPool *pool);
+
+// Complex-to-real inverse of count half spectra stored back to back, each H rows of W/2 + 1 bins
+// (kx = 0..W/2, ky in FFT order) of a Hermitian spectrum, into count real W x H fields in out,
+// un-normalized. halfSpectra is used as scratch and overwritten.
+void executeIFFT2DC2RBatchCPU(FFTPlanCPU *plan, Complex *halfSpectra, float *out, int count, ThreadPool *pool);
+
+// Convenience wrapper: copies the spectrum to out and transforms it with a plan cached per
+// calling thread, so threads may call it concurrently. Prefer createFFTPlanCPU for repeated work.
+bool computeIFFT2DCPU(const Complex *spectrum, Complex *out, int W, int H);
@@ -1,17 +1,51 @@
-// Basic includes for OpenGL context via MicroGlut.
-#include "MicroGlut.h"
-#include "GL_utilities.h"
+#pragma once
 
-// Simple complex number used for GPU buffers (float2).
-struct Complex
-{
-    float x;
-    float y;
-};
+// GL headers only; the caller owns the context (MicroGlut window or headless EGL).
+#include "GL_utilities.h"
+#include "fft_complex.h"
 
 // Compile and link a compute shader from file path (used by ocean module).
 GLuint loadComputeShader(const char *path);
 
+// Persistent 2D FFT plan: owns the ping-pong scratch buffers so steady-state transforms allocate nothing.
+struct FFTPlanGPU;
+
+// maxBatch is the largest number of fields a single execute call may transform. realOutput plans
+// only hold H x (W/2 + 1) complex per field and only support executeIFFT2DC2RBatchGPU.
+// halfStorage plans read their input, keep their scratch and return their output as
+// packHalf2x16 values, one uint per complex value or per pair of real outputs; the butterflies
+// still run in fp32.
+FFTPlanGPU *createFFTPlanGPU(int W, int H, int maxBatch = 1, bool realOutput = false, bool halfStorage = false);
+void destroyFFTPlanGPU(FFTPlanGPU *plan);
+
+// Inverse 2D FFT of spectrumSSBO (left untouched). The returned SSBO belongs to the plan and is
+// overwritten by the next execute; un-normalized like computeIFFT2D.
+GLuint executeIFFT2DGPU(FFTPlanGPU *plan, GLuint spectrumSSBO);
+// Same for count W x H spectra stored back to back, with one dispatch per stage for all of them.
+GLuint executeIFFT2DBatchGPU(FFTPlanGPU *plan, GLuint spectraSSBO, int count);
+// Complex-to-real inverse of count half spectra stored back to back, each H rows of W/2 + 1 bins
+// (kx = 0..W/2, ky in FFT order 0..H-1) of a Hermitian spectrum. The returned SSBO (owned by the
+// plan) holds count real W x H fields back to back as floats, un-normalized. W must be >= 4.
+GLuint executeIFFT2DC2RBatchGPU(FFTPlanGPU *plan, GLuint halfSpectraSSBO, int count);
+
+// Twiddle factors, bit-reversed positions and butterfly inputs come from per-length tables built
+// once (enabled by default). Disabling recomputes them per butterfly with cos/sin, as a
+// reference for benchmarks and accuracy checks.
+void setFFTTablesEnabledGPU(bool enabled);
+
+// Axis of the 1D passes of a 2D transform: rows run along W, columns along H.
+enum FFTAxisGPU
+{
+    kFFTAxisRows,
+    kFFTAxisColumns
+};
+// Called right before (begin) and after the passes of each axis of every 2D transform, e.g. to
+// bracket them with timer queries. nullptr (the default) disables it.
+void setFFTPassHookGPU(void (*hook)(FFTAxisGPU axis, bool begin));
+// Running totals (wrapping) of the compute dispatches and memory barriers issued by all transforms.
+void getFFTCountersGPU(unsigned *dispatches, unsigned *barriers);
+
 // Compute 2D inverse FFT: takes spectrum SSBO (row-major kx fastest), runs column then row inverse passes.
 // Returns SSBO with time-domain data (un-normalized, divide by W*H to get original amplitudes).
+// Allocates per call and the caller must delete the result; prefer a plan for per-frame work.
 GLuint computeIFFT2D(GLuint spectrumSSBO, int W, int H);
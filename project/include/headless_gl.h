@@ -0,0 +1,7 @@
+#pragma once
+
+// Window-free OpenGL context for batch tools (EGL surfaceless / device platform, no display needed).
+
+// Create and make current a core-profile context of at least the given version.
+bool HeadlessGL_Init(int major = 4, int minor = 3);
+void HeadlessGL_Shutdown();
@@ -1,45 +1,100 @@
 #pragma once
 
-#include <cstdint>
-
 #include "GL_utilities.h"
+#include "ocean_params.h"
 
-constexpr float kDefaultOceanAlpha = 0.04f;
-constexpr float kDefaultOceanGamma = 10.3f;
+// Initialize ocean simulation resources (SSBOs, compute shaders, textures). Calling it again
+// replaces the previous resources; compiled shaders are reused.
+void Ocean_Init(OceanInitParams params = OceanInitParams());
+// Release all GL resources owned by the ocean module.
+void Ocean_Shutdown();
 
-// Minimal 2D vector for spectrum parameterization.
-struct OceanVec2
+// What a parameter change requires (bit mask returned by Ocean_SetParams).
+enum OceanParamChange
 {
-	float x;
-	float y;
+    kOceanChangeNone = 0,
+    kOceanChangeUniforms = 1 << 0,  // time_scale, amplitudeScale, choppiness: new uniform values only
+    kOceanChangeSpectrum = 1 << 1,  // wind, alpha, gamma, spreading, cutoffs, seed, domainSize, gravity, detail cascades: H0 regenerated in place
+    kOceanChangeResolution = 1 << 2 // resolution, cascadeCount, precision, outputLayout, normalMap: buffers and textures reallocated
 };
+unsigned Ocean_ClassifyParamChange(const OceanInitParams &from, const OceanInitParams &to);
+
+// Apply new parameters doing only the work the change needs (see OceanParamChange). Texture
+// names stay valid unless the resolution changed. The dispersion table is rebuilt only when
+// gravity or a cascade's domainSize changes.
+unsigned Ocean_SetParams(const OceanInitParams &params);
+
+// Advance ocean simulation one frame and update height/slope textures.
+void Ocean_Update();
+// Same as Ocean_Update but at an explicit simulation time (seconds, scaled by time_scale),
+// for deterministic offline baking.
+void Ocean_UpdateAtTime(float seconds);
+
+// Fixed-timestep runs (offline bakes, fixed-rate simulation): when every update is exactly
+// `seconds` after the previous one, the evolve stage advances each frequency's phase by a cached
+// e^{iw dt} instead of evaluating cos/sin, re-syncing to the exact phase every 64 steps. Any other
+// update time falls back to the exact phase. 0 (the default) always uses the exact phase.
+void Ocean_SetFixedTimestep(float seconds);
 
-// Tunable parameters controlling the initial ocean spectrum.
-struct OceanInitParams
+// GPU stages of an update, in order.
+enum OceanStage
 {
-	float time_scale = 1.0f;   // Speed multiplier for wave evolution
-	int resolution = 512;	   // FFT grid resolution (power of two recommended)
-	float domainSize = 256.0f; // Physical side length of the simulated patch (meters)
-	OceanVec2 windDirection = {1.0f, 0.3f};
-	float windSpeed = 30.0f;		  // 10m wind speed in m/s
-	float alpha = kDefaultOceanAlpha; // Phillips / PM base spectrum energy scale
-	float gamma = kDefaultOceanGamma; // JONSWAP peak amplification
-	float spreadExponent = 5.0f;	  // Directional spreading exponent (>0 narrows peak)
-	float lowCutoff = 0.0f;			  // Optional soft damping for long waves (rad/m)
-	float highCutoff = 1.5f;		  // Optional soft damping for capillaries (rad/m)
-	float gravity = 9.81f;			  // Gravitational acceleration (m/s^2)
-	float amplitudeScale = 5000.0f;	  // Height amplitude multiplier for water shaders
-	float choppiness = 3.0f;		  // Horizontal displacement strength
-	uint32_t randomSeed = 132234u;	  // RNG seed for reproducible spectra (0 -> random)
+    kOceanStageEvolve,     // spectrum evolution and derivative spectra
+    kOceanStageFFTColumns, // column passes of the batched complex-to-real inverse FFT
+    kOceanStageFFTRows,    // row passes (the complex-to-real ones)
+    kOceanStageOutputs,    // normalization, jacobian and output textures
+    kOceanStageCount
 };
+// Frame profiler (on by default): each stage of an update is bracketed with GL_TIMESTAMP queries
+// and CPU timestamps. Query results are collected kOceanStatsLatency updates later without waiting
+// for them, so profiling never stalls the pipeline. Disabling it stops both.
+void Ocean_SetStageTiming(bool enabled);
+// GPU milliseconds of each stage (kOceanStageCount values) of the last update, 0 for a stage that
+// did not run. Waits for the queries, so it is meant for benchmarks. False without a timed update.
+bool Ocean_GetStageTimes(double *ms);
 
-// Initialize ocean simulation resources (SSBOs, compute shaders, textures).
-void Ocean_Init(OceanInitParams params = OceanInitParams());
+constexpr int kOceanStatsFrames = 128; // frames kept by the profiler
+constexpr int kOceanStatsLatency = 2;  // updates between a frame and its statistics (query sets)
 
-// Advance ocean simulation one frame and update height/slope textures.
-void Ocean_Update();
+// Profile of one update.
+struct OceanFrameStats
+{
+    uint64_t frame;                // profiled updates before this one
+    float gpuMs[kOceanStageCount]; // 0: the stage did not run; -1: queries not finished in time
+    float cpuMs[kOceanStageCount]; // issuing the stage's GL commands
+    float cpuFrameMs;              // the whole update on the CPU, parameter changes included
+    uint32_t dispatches;           // compute dispatches
+    uint32_t barriers;             // glMemoryBarrier calls
+};
 
-// Getters for ocean height and slope textures used by water shader.
+// The last frames published by the profiler, oldest first.
+struct OceanStats
+{
+    int count;
+    OceanFrameStats frames[kOceanStatsFrames];
+};
+
+// Copies the profiler's ring of recent frames. Lock-free: callable from any thread while another
+// one updates; frames overwritten during the copy are left out.
+void Ocean_GetStats(OceanStats &stats);
+// Writes every frame published from now on as a CSV row to path (header first), in batches of
+// intervalFrames (at most kOceanStatsFrames / 2) from a background thread that reads the ring
+// like Ocean_GetStats, so the update does no file I/O. Frames the ring overwrites before the
+// writer sees them are skipped. nullptr stops dumping and writes the remaining frames.
+bool Ocean_SetStatsCSV(const char *path, int intervalFrames = 60);
+
+// Output textures: GL_TEXTURE_2D_ARRAYs with one layer per cascade, arranged by
+// OceanInitParams::outputLayout. Returns the array holding a field and, through channel, its
+// component (0 = red): always 0 with separate textures; packed, height is 1 and dispZ 2 of the
+// displacement array, slopeZ 1 and the jacobian 2 of the slope array.
+GLuint Ocean_GetFieldTexture(OceanField field, int *channel = nullptr);
+OceanOutputLayout Ocean_GetOutputLayout();
+// Packed layout arrays, 0 with separate textures.
+GLuint Ocean_GetDisplacementTexture();
+GLuint Ocean_GetSlopeTexture();
+
+// Getters for ocean height and slope textures used by water shader: Ocean_GetFieldTexture of the
+// field, so with the packed layout they return the packed array holding it.
 GLuint Ocean_GetHeightTexture();
 GLuint Ocean_GetSlopeXTexture();
 GLuint Ocean_GetSlopeZTexture();
@@ -47,11 +102,66 @@ GLuint Ocean_GetSlopeZTexture();
 GLuint Ocean_GetDispXTexture();
 GLuint Ocean_GetDispZTexture();
 GLuint Ocean_GetJacobianTexture();
+// RGBA8 signed normalized array of per-cascade surface normals (xyz), 0 unless
+// OceanInitParams::normalMap is set.
+GLuint Ocean_GetNormalTexture();
+
+// Fields overridden by an OceanParamDelta (bit mask).
+enum OceanParamField
+{
+    kOceanParamTimeScale = 1 << 0,
+    kOceanParamResolution = 1 << 1,
+    kOceanParamDomainSize = 1 << 2,
+    kOceanParamWindDirection = 1 << 3,
+    kOceanParamWindSpeed = 1 << 4,
+    kOceanParamAlpha = 1 << 5,
+    kOceanParamGamma = 1 << 6,
+    kOceanParamSpreadExponent = 1 << 7,
+    kOceanParamLowCutoff = 1 << 8,
+    kOceanParamHighCutoff = 1 << 9,
+    kOceanParamGravity = 1 << 10,
+    kOceanParamAmplitudeScale = 1 << 11,
+    kOceanParamChoppiness = 1 << 12,
+    kOceanParamRandomSeed = 1 << 13,
+    kOceanParamCascades = 1 << 14, // cascadeCount and detailCascades
+    kOceanParamPrecision = 1 << 15,
+    kOceanParamOutputLayout = 1 << 16,
+    kOceanParamNormalMap = 1 << 17
+};
+
+// Partial parameter update: only the fields named in the mask are taken from values.
+struct OceanParamDelta
+{
+    uint32_t fields;
+    OceanInitParams values;
+};
+
+// Queue a parameter change from another thread (e.g. a telemetry feed). Lock-free and
+// non-blocking; only one thread may push. The next Ocean_Update/Ocean_UpdateAtTime drains the
+// queue before simulating, merges every pending delta and applies them with a single
+// Ocean_SetParams, so bursts cost at most one spectrum regeneration per frame. If the queue is
+// full the delta is merged into a spill slot the next update applies after the queue, so the
+// newest values are never lost.
+void Ocean_PushParamDelta(const OceanParamDelta &delta);
+
+// Read one cascade of an output field back to the CPU (resolution x resolution floats, row-major).
+void Ocean_ReadField(OceanField field, float *dst, int cascade = 0);
+
+// Rebuild the initial spectrum from new spectrum parameters (wind, alpha, gamma, spreading,
+// cutoffs, seed) with one compute dispatch; resolution, patch size and scales are kept.
+void Ocean_RegenerateSpectrum(const OceanInitParams &params);
+
+// Read the initial spectrum of the primary cascade back: N x (N/2 + 1) half-spectrum bins of
+// (h0(k), h0(-k)), 4 floats each.
+void Ocean_ReadH0(float *dst);
 
 // Accessors for shader configuration values.
 float Ocean_GetPatchSize();
 float Ocean_GetAmplitudeScale();
 float Ocean_GetChoppiness();
+// Active cascade count and the world size of one cascade's patch (0 = primary patch).
+int Ocean_GetCascadeCount();
+float Ocean_GetCascadeSize(int cascade);
 
 // Access the active initialization parameters.
 const OceanInitParams &Ocean_GetParams();
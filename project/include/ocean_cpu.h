@@ -0,0 +1,20 @@
+#pragma once
+
+#include "ocean_params.h"
+
+struct ThreadPool;
+
+// CPU implementation of the ocean pipeline (no GL context needed). Produces the same fields as
+// the compute shader path in ocean.cpp; several instances can share one pool.
+struct OceanCPU;
+
+// Generate H0 and allocate spectra/output fields. pool may be null (single-threaded).
+OceanCPU *OceanCPU_Create(const OceanInitParams &params, ThreadPool *pool);
+void OceanCPU_Destroy(OceanCPU *ocean);
+
+// Evolve to the given time (seconds, scaled by time_scale) and rebuild all output fields.
+void OceanCPU_Update(OceanCPU *ocean, float seconds);
+
+// Row-major resolution x resolution field, valid until the next update.
+const float *OceanCPU_GetField(const OceanCPU *ocean, OceanField field);
+const OceanInitParams &OceanCPU_GetParams(const OceanCPU *ocean);
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <cstdint>
+
+constexpr float kDefaultOceanAlpha = 0.04f;
+constexpr float kDefaultOceanGamma = 10.3f;
+
+constexpr int kOceanMaxCascades = 4;
+
+// Minimal 2D vector for spectrum parameterization.
+struct OceanVec2
+{
+	float x;
+	float y;
+};
+
+// Storage of the GPU spectra, FFT scratch and output textures. Half packs each complex value
+// with packHalf2x16 and uses R16F textures: half the bandwidth, about three decimal digits.
+enum OceanPrecision
+{
+	kOceanPrecisionFull,
+	kOceanPrecisionHalf
+};
+
+// How the GPU outputs are arranged in texture arrays (see Ocean_GetFieldTexture). Separate: one
+// single-channel array per field. Packed: an RGBA displacement array (dispX, height, dispZ) and an
+// RGBA slope array (slopeX, slopeZ, jacobian), so a draw binds two textures and fetches each once.
+enum OceanOutputLayout
+{
+	kOceanOutputSeparate,
+	kOceanOutputPacked
+};
+
+// Smaller detail patch layered over the primary one. Its band is limited with the same soft
+// cutoffs as the primary spectrum; choose them so neighbouring cascades meet rather than overlap.
+struct OceanCascadeParams
+{
+	float domainSize; // meters
+	float lowCutoff;  // rad/m, 0 disables
+	float highCutoff; // rad/m, 0 disables
+};
+
+// Tunable parameters controlling the initial ocean spectrum.
+struct OceanInitParams
+{
+	float time_scale = 1.0f;   // Speed multiplier for wave evolution
+	int resolution = 512;	   // FFT grid resolution (power of two recommended)
+	float domainSize = 256.0f; // Physical side length of the simulated patch (meters)
+	OceanVec2 windDirection = {1.0f, 0.3f};
+	float windSpeed = 30.0f;		  // 10m wind speed in m/s
+	float alpha = kDefaultOceanAlpha; // Phillips / PM base spectrum energy scale
+	float gamma = kDefaultOceanGamma; // JONSWAP peak amplification
+	float spreadExponent = 5.0f;	  // Directional spreading exponent (>0 narrows peak)
+	float lowCutoff = 0.0f;			  // Optional soft damping for long waves (rad/m)
+	float highCutoff = 1.5f;		  // Optional soft damping for capillaries (rad/m)
+	float gravity = 9.81f;			  // Gravitational acceleration (m/s^2)
+	float amplitudeScale = 5000.0f;	  // Height amplitude multiplier for water shaders
+	float choppiness = 3.0f;		  // Horizontal displacement strength
+	uint32_t randomSeed = 132234u;	  // RNG seed for reproducible spectra (0 -> random)
+	int cascadeCount = 1;			  // Primary patch plus cascadeCount - 1 detail cascades (GPU only)
+	OceanCascadeParams detailCascades[kOceanMaxCascades - 1] = {
+		{64.0f, 1.5f, 6.0f}, {16.0f, 6.0f, 24.0f}, {4.0f, 24.0f, 96.0f}};
+	OceanPrecision precision = kOceanPrecisionFull; // GPU only
+	OceanOutputLayout outputLayout = kOceanOutputSeparate; // GPU only
+	bool normalMap = false; // GPU only: also write each cascade's normal (Ocean_GetNormalTexture)
+};
+
+// Real-valued fields produced by the ocean pipeline (CPU arrays and GPU textures alike).
+enum OceanField
+{
+	kOceanFieldHeight,
+	kOceanFieldSlopeX,
+	kOceanFieldSlopeZ,
+	kOceanFieldDispX,
+	kOceanFieldDispZ,
+	kOceanFieldJacobian,
+	kOceanFieldCount
+};
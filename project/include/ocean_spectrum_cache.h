@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstdint>
+
+struct Complex;
+struct OceanInitParams;
+
+// On-disk cache of initial spectra (H0 half-spectrum pairs as packed by Ocean_PackHalfSpectrumH0),
+// one versioned binary file per parameter set and generator, keyed by a hash of every
+// OceanInitParams field and the generator. Entries are memory-mapped so a hit can be uploaded or
+// copied straight from the page cache. Params with randomSeed 0 (fresh random spectrum) are never
+// cached.
+struct OceanSpectrumCacheEntry;
+
+// Which code produced a spectrum. The CPU generator and ocean_h0.comp differ in the last bits, so
+// each only ever reads back its own entries and CPU results do not depend on the cache history.
+enum OceanSpectrumGenerator
+{
+    kOceanSpectrumGeneratorCPU, // Ocean_GenerateH0
+    kOceanSpectrumGeneratorGPU  // ocean_h0.comp
+};
+
+// Directory holding the cache files (created on first store); nullptr or "" disables the cache.
+// Defaults to $OCEAN_SPECTRUM_CACHE if set, otherwise "out/cache".
+void OceanSpectrumCache_SetDirectory(const char *dir);
+
+// 64-bit FNV-1a over all parameter fields and the generator.
+uint64_t OceanSpectrumCache_Key(const OceanInitParams &params, OceanSpectrumGenerator generator);
+
+// Maps the cached spectrum for params read-only; nullptr on a miss or an invalid/stale file.
+OceanSpectrumCacheEntry *OceanSpectrumCache_Open(const OceanInitParams &params, OceanSpectrumGenerator generator);
+// 2 * N * (N/2 + 1) entries, valid until the entry is closed.
+const Complex *OceanSpectrumCache_Pairs(const OceanSpectrumCacheEntry *entry);
+
+// Maps a new, writable temporary file for params and returns its pairs array in *pairs.
+// Fill it and call OceanSpectrumCache_Commit to publish it; nullptr when caching is off or fails.
+OceanSpectrumCacheEntry *OceanSpectrumCache_Create(const OceanInitParams &params, OceanSpectrumGenerator generator,
+                                                   Complex **pairs);
+// Atomically publishes a created entry (rename over the final name) and closes it.
+bool OceanSpectrumCache_Commit(OceanSpectrumCacheEntry *entry);
+
+// Unmaps the entry; an uncommitted created entry is discarded.
+void OceanSpectrumCache_Close(OceanSpectrumCacheEntry *entry);
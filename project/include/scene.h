@@ -4,10 +4,12 @@
 
 // Global scene models
 extern Model *terrainModel;
-extern Model *planeModel;
 
-// Create a subdivided plane centered at origin on the XZ plane (Y=0)
-Model *CreateSubdividedPlane(int divisions, float size);
-
-// Load teapot and create plane model
+// Load teapot and create the water clipmap buffers
 void Scene_InitModels();
+
+// Draw the water surface as a clipmap centred on cameraPos: nested grid rings whose cell size
+// doubles per level, from fine detail at the camera out to the far plane. No vertex attributes:
+// water.vert builds each vertex from gl_VertexID and u_LevelOrigin / u_LevelCellSize /
+// u_GridHalfCells.
+void Scene_DrawWater(GLuint program, vec3 cameraPos);
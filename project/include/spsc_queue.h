@@ -0,0 +1,42 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+// Bounded single-producer/single-consumer ring buffer. Push and pop never block or allocate:
+// exactly one thread may push and exactly one other thread may pop. head and tail are
+// free-running counters, so all Capacity slots are usable (Capacity must be a power of two).
+template <typename T, uint32_t Capacity>
+struct SPSCQueue
+{
+    static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0, "capacity must be a power of two");
+
+    // Separate cache lines so producer and consumer do not false-share the counters
+    alignas(64) std::atomic<uint32_t> head{0}; // next slot to pop, written by the consumer
+    alignas(64) std::atomic<uint32_t> tail{0}; // next slot to push, written by the producer
+    alignas(64) T items[Capacity];
+};
+
+// Producer side; false when the queue is full (the item is dropped).
+template <typename T, uint32_t Capacity>
+bool SPSCQueue_Push(SPSCQueue<T, Capacity> &queue, const T &item)
+{
+    const uint32_t tail = queue.tail.load(std::memory_order_relaxed);
+    if (tail - queue.head.load(std::memory_order_acquire) == Capacity)
+        return false;
+    queue.items[tail & (Capacity - 1)] = item;
+    queue.tail.store(tail + 1, std::memory_order_release);
+    return true;
+}
+
+// Consumer side; false when the queue is empty.
+template <typename T, uint32_t Capacity>
+bool SPSCQueue_Pop(SPSCQueue<T, Capacity> &queue, T &item)
+{
+    const uint32_t head = queue.head.load(std::memory_order_relaxed);
+    if (head == queue.tail.load(std::memory_order_acquire))
+        return false;
+    item = queue.items[head & (Capacity - 1)];
+    queue.head.store(head + 1, std::memory_order_release);
+    return true;
+}
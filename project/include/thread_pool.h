@@ -0,0 +1,17 @@
+#pragma once
+
+#include <functional>
+
+// Fixed-size worker pool for data-parallel loops (row/column passes, per-texel kernels).
+struct ThreadPool;
+
+// Create a pool of threadCount threads including the calling thread (0 -> hardware concurrency).
+ThreadPool *ThreadPool_Create(int threadCount = 0);
+void ThreadPool_Destroy(ThreadPool *pool);
+int ThreadPool_GetThreadCount(const ThreadPool *pool);
+
+// Run fn(begin, end, worker) over [0, count) in chunks of at most grain items and wait until all are done.
+// Chunks are split evenly up front; a worker that runs dry steals half of another worker's remaining chunks.
+// The caller participates as worker 0. A null pool runs the loop serially. Not reentrant.
+void ThreadPool_ParallelFor(ThreadPool *pool, int count, int grain,
+                            const std::function<void(int begin, int end, int worker)> &fn);
@@ -175,33 +175,24 @@ void init(void)
     skybox_init();
 
     // Initialize Tessendorf ocean module (SSBOs, compute shaders, textures)
-    Ocean_Init();
+    // Packed outputs: water.vert and water.frag fetch one texture per cascade each
+    OceanInitParams initParams;
+    initParams.outputLayout = kOceanOutputPacked;
+    Ocean_Init(initParams);
 
     // Bind sampler units and shader uniforms that depend on ocean parameters
     const OceanInitParams &oceanParams = Ocean_GetParams();
     glUseProgram(waterProgram);
-    GLint locHM = glGetUniformLocation(waterProgram, "u_HeightMap");
-    if (locHM >= 0)
-        glUniform1i(locHM, 0);
-    GLint locSX = glGetUniformLocation(waterProgram, "u_SlopeXMap");
-    if (locSX >= 0)
-        glUniform1i(locSX, 1);
-    GLint locSZ = glGetUniformLocation(waterProgram, "u_SlopeZMap");
-    if (locSZ >= 0)
-        glUniform1i(locSZ, 2);
-    GLint locDX = glGetUniformLocation(waterProgram, "u_DispX");
-    if (locDX >= 0)
-        glUniform1i(locDX, 3);
-    GLint locDZ = glGetUniformLocation(waterProgram, "u_DispZ");
-    if (locDZ >= 0)
-        glUniform1i(locDZ, 4);
-    GLint locJac = glGetUniformLocation(waterProgram, "u_JacobianMap");
-    if (locJac >= 0)
-        glUniform1i(locJac, 5);
+    GLint locDisp = glGetUniformLocation(waterProgram, "u_Displacement");
+    if (locDisp >= 0)
+        glUniform1i(locDisp, 0);
+    GLint locSlope = glGetUniformLocation(waterProgram, "u_SlopeMap");
+    if (locSlope >= 0)
+        glUniform1i(locSlope, 1);
 
     GLint locSkybox = glGetUniformLocation(waterProgram, "u_Skybox");
     if (locSkybox >= 0)
-        glUniform1i(locSkybox, 6);
+        glUniform1i(locSkybox, 2);
 
     GLint locGrid = glGetUniformLocation(waterProgram, "u_GridSize");
     if (locGrid >= 0)
@@ -245,26 +236,27 @@ void display(void)
     // Draw skybox first
     draw_skybox();
 
-    // Draw the loaded model if available
-    if (planeModel != NULL)
+    // Draw the water surface around the camera
     {
         glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, Ocean_GetHeightTexture());
+        glBindTexture(GL_TEXTURE_2D_ARRAY, Ocean_GetDisplacementTexture());
         glActiveTexture(GL_TEXTURE1);
-        glBindTexture(GL_TEXTURE_2D, Ocean_GetSlopeXTexture());
+        glBindTexture(GL_TEXTURE_2D_ARRAY, Ocean_GetSlopeTexture());
         glActiveTexture(GL_TEXTURE2);
-        glBindTexture(GL_TEXTURE_2D, Ocean_GetSlopeZTexture());
-        glActiveTexture(GL_TEXTURE3);
-        glBindTexture(GL_TEXTURE_2D, Ocean_GetDispXTexture());
-        glActiveTexture(GL_TEXTURE5);
-        glBindTexture(GL_TEXTURE_2D, Ocean_GetJacobianTexture());
-        glActiveTexture(GL_TEXTURE4);
-        glBindTexture(GL_TEXTURE_2D, Ocean_GetDispZTexture());
-        glActiveTexture(GL_TEXTURE6);
         glBindTexture(GL_TEXTURE_CUBE_MAP, skyboxTexture);
         glActiveTexture(GL_TEXTURE0);
-        DrawModel(planeModel, waterProgram, "in_Position", NULL, "in_TexCoord");
-        
+
+        // Ocean_SetParams may change these between frames
+        glUseProgram(waterProgram);
+        glUniform1f(glGetUniformLocation(waterProgram, "u_GridSize"), Ocean_GetPatchSize());
+        glUniform1f(glGetUniformLocation(waterProgram, "u_Amplitude"), Ocean_GetAmplitudeScale());
+        glUniform1f(glGetUniformLocation(waterProgram, "u_Choppiness"), Ocean_GetChoppiness());
+        float cascadeSizes[kOceanMaxCascades];
+        for (int c = 0; c < Ocean_GetCascadeCount(); ++c)
+            cascadeSizes[c] = Ocean_GetCascadeSize(c);
+        glUniform1i(glGetUniformLocation(waterProgram, "u_CascadeCount"), Ocean_GetCascadeCount());
+        glUniform1fv(glGetUniformLocation(waterProgram, "u_CascadeSizes"), Ocean_GetCascadeCount(), cascadeSizes);
+        Scene_DrawWater(waterProgram, Camera_GetPosition());
     }
 
     printError("display");
@@ -0,0 +1,203 @@
+// Headless ocean baker: runs the simulation without a window and writes every output field per frame.
+//
+// Usage: ocean_bake [--frames N] [--resolution N] [--dt seconds] [--cpu] [--threads T]
+//                   [--out DIR] [--no-write] [--no-cache] [--cascades C] [--fixed-step]
+//                   [--half] [--packed]
+//
+// GPU mode creates a surfaceless EGL context; --cpu runs the CPU pipeline and needs no GL at all.
+// Each frame is written to DIR/frame_NNNNN.ocean: a BakeFrameHeader followed by kOceanFieldCount
+// resolution x resolution float32 planes in OceanField order (height, slopeX, slopeZ, dispX, dispZ,
+// jacobian), unscaled as they come out of the pipeline. --no-cache skips the on-disk spectrum cache
+// (ocean_spectrum_cache.h) so initialization always regenerates H0. --cascades simulates C cascades
+// on the GPU; only the primary one is written. --fixed-step advances the GPU phases by the cached
+// e^{iw dt} rotation between frames (Ocean_SetFixedTimestep) instead of evaluating them exactly.
+// --half runs the GPU pipeline with kOceanPrecisionHalf storage; frames are still written as floats.
+// --packed uses the kOceanOutputPacked texture layout; the written planes are the same.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <sys/stat.h>
+#include <chrono>
+#include <vector>
+
+#include "GL_utilities.h"
+#include "headless_gl.h"
+#include "ocean.h"
+#include "ocean_cpu.h"
+#include "ocean_spectrum_cache.h"
+#include "thread_pool.h"
+
+struct BakeFrameHeader
+{
+    char magic[4];        // "OCNF"
+    uint32_t version;     // 1
+    uint32_t resolution;  // N
+    uint32_t fieldCount;  // kOceanFieldCount
+    float time;           // simulation time of the frame (seconds, before time_scale)
+    float domainSize;     // patch size in meters
+    float amplitudeScale; // multiply height/slopes by this to get meters
+    float choppiness;     // horizontal displacement multiplier
+};
+
+struct BakeOptions
+{
+    int frames = 100;
+    int resolution = 512;
+    float dt = 1.0f / 30.0f;
+    bool cpu = false;
+    int threads = 0;
+    const char *outDir = "out/bake";
+    bool write = true;
+    bool cache = true;
+    int cascades = 1;
+    bool fixedStep = false;
+    bool half = false;
+    bool packed = false;
+};
+
+static bool parseOptions(int argc, char *argv[], BakeOptions &options)
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        const char *arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (!strcmp(arg, "--frames") && hasValue)
+            options.frames = atoi(argv[++i]);
+        else if (!strcmp(arg, "--resolution") && hasValue)
+            options.resolution = atoi(argv[++i]);
+        else if (!strcmp(arg, "--dt") && hasValue)
+            options.dt = static_cast<float>(atof(argv[++i]));
+        else if (!strcmp(arg, "--cascades") && hasValue)
+            options.cascades = atoi(argv[++i]);
+        else if (!strcmp(arg, "--threads") && hasValue)
+            options.threads = atoi(argv[++i]);
+        else if (!strcmp(arg, "--out") && hasValue)
+            options.outDir = argv[++i];
+        else if (!strcmp(arg, "--cpu"))
+            options.cpu = true;
+        else if (!strcmp(arg, "--no-write"))
+            options.write = false;
+        else if (!strcmp(arg, "--half"))
+            options.half = true;
+        else if (!strcmp(arg, "--packed"))
+            options.packed = true;
+        else if (!strcmp(arg, "--fixed-step"))
+            options.fixedStep = true;
+        else if (!strcmp(arg, "--no-cache"))
+            options.cache = false;
+        else
+        {
+            printf("Usage: %s [--frames N] [--resolution N] [--dt seconds] [--cpu] [--threads T] [--out DIR] [--no-write] [--no-cache] [--cascades C] [--fixed-step] [--half] [--packed]\n", argv[0]);
+            return false;
+        }
+    }
+    return options.frames > 0 && options.resolution > 0;
+}
+
+static bool writeFrame(const BakeOptions &options, int frame, const BakeFrameHeader &header, const std::vector<float> &fields)
+{
+    char path[1024];
+    snprintf(path, sizeof(path), "%s/frame_%05d.ocean", options.outDir, frame);
+    FILE *file = fopen(path, "wb");
+    if (!file)
+    {
+        printf("Could not open %s for writing.\n", path);
+        return false;
+    }
+    bool ok = fwrite(&header, sizeof(header), 1, file) == 1 &&
+              fwrite(fields.data(), sizeof(float), fields.size(), file) == fields.size();
+    fclose(file);
+    return ok;
+}
+
+int main(int argc, char *argv[])
+{
+    BakeOptions options;
+    if (!parseOptions(argc, argv, options))
+        return 1;
+
+    OceanInitParams params;
+    params.resolution = options.resolution;
+    params.cascadeCount = options.cascades;
+    params.precision = options.half ? kOceanPrecisionHalf : kOceanPrecisionFull;
+    params.outputLayout = options.packed ? kOceanOutputPacked : kOceanOutputSeparate;
+    if (!options.cache)
+        OceanSpectrumCache_SetDirectory(nullptr);
+
+    const size_t fieldSize = static_cast<size_t>(options.resolution) * options.resolution;
+    std::vector<float> fields(kOceanFieldCount * fieldSize);
+
+    ThreadPool *pool = nullptr;
+    OceanCPU *oceanCPU = nullptr;
+    if (options.cpu)
+    {
+        pool = ThreadPool_Create(options.threads);
+        oceanCPU = OceanCPU_Create(params, pool);
+        if (!oceanCPU)
+            return 1;
+        params = OceanCPU_GetParams(oceanCPU);
+        printf("CPU pipeline, %d thread(s)\n", ThreadPool_GetThreadCount(pool));
+    }
+    else
+    {
+        if (!HeadlessGL_Init(4, 3))
+            return 1;
+        Ocean_Init(params);
+        params = Ocean_GetParams();
+        if (options.fixedStep)
+            Ocean_SetFixedTimestep(options.dt);
+    }
+
+    if (options.write)
+        mkdir(options.outDir, 0755);
+
+    BakeFrameHeader header = {{'O', 'C', 'N', 'F'}, 1u, static_cast<uint32_t>(options.resolution),
+                              static_cast<uint32_t>(kOceanFieldCount), 0.0f,
+                              params.domainSize, params.amplitudeScale, params.choppiness};
+
+    using namespace std::chrono;
+    double simSeconds = 0.0;
+    auto start = steady_clock::now();
+    for (int frame = 0; frame < options.frames; ++frame)
+    {
+        const float time = frame * options.dt;
+        auto simStart = steady_clock::now();
+        if (oceanCPU)
+        {
+            OceanCPU_Update(oceanCPU, time);
+            for (int field = 0; field < kOceanFieldCount; ++field)
+                memcpy(fields.data() + field * fieldSize, OceanCPU_GetField(oceanCPU, static_cast<OceanField>(field)), fieldSize * sizeof(float));
+        }
+        else
+        {
+            Ocean_UpdateAtTime(time);
+            for (int field = 0; field < kOceanFieldCount; ++field)
+                Ocean_ReadField(static_cast<OceanField>(field), fields.data() + field * fieldSize);
+        }
+        simSeconds += duration<double>(steady_clock::now() - simStart).count();
+
+        header.time = time;
+        if (options.write && !writeFrame(options, frame, header, fields))
+            return 1;
+    }
+    double totalSeconds = duration<double>(steady_clock::now() - start).count();
+
+    printf("Baked %d frames at %dx%d: %.2f frames/s overall, %.2f frames/s simulation+readback (%.3f ms/frame)\n",
+           options.frames, options.resolution, options.resolution,
+           options.frames / totalSeconds, options.frames / simSeconds, 1000.0 * simSeconds / options.frames);
+
+    if (oceanCPU)
+    {
+        OceanCPU_Destroy(oceanCPU);
+        ThreadPool_Destroy(pool);
+    }
+    else
+    {
+        GLenum error = glGetError();
+        if (error != GL_NO_ERROR)
+            printf("GL error 0x%x during bake.\n", error);
+        HeadlessGL_Shutdown();
+    }
+    return 0;
+}
@@ -12,10 +12,12 @@ uniform float roughness = 0.1; // surface roughness
 uniform vec3 baseReflectance = vec3(0.02);
 uniform vec3 sunColor = vec3(1.0, 0.82, 0.64); // warmer golden-orange sunlight tint
 
-uniform sampler2D u_SlopeXMap;
-uniform sampler2D u_SlopeZMap;
-uniform sampler2D u_JacobianMap;
+#define MAX_CASCADES 4
+
+uniform sampler2DArray u_SlopeMap; // packed (slopeX, slopeZ, jacobian), one layer per cascade
 uniform float u_Amplitude;
+uniform int u_CascadeCount;
+uniform float u_CascadeSizes[MAX_CASCADES];
 uniform samplerCube u_Skybox;
 
 uniform vec3 scatteringColor = vec3(0.0, 0.4, 0.5);
@@ -84,29 +86,38 @@ vec3 computeSubsurfaceScattering(vec3 normal, vec3 viewDir, vec3 lightDir, vec3
 	return k1k2Scatter + k3Scatter + k4Scatter;
 }
 
-// Derive per-fragment normal directly from slope textures.
-vec3 computeWaveNormal(vec2 uv, out vec2 slopes)
+// Texture coordinate of cascade c for the primary patch coordinate uv.
+vec3 cascadeCoord(vec2 uv, int c)
+{
+	return vec3(uv * (u_CascadeSizes[0] / u_CascadeSizes[c]), float(c));
+}
+
+// Slopes and jacobian summed over the cascades with one fetch each. Each cascade's compression
+// adds up: J = 1 + sum(J_c - 1).
+vec3 sampleSlopes(vec2 uv)
 {
-	ivec2 texDim = textureSize(u_SlopeXMap, 0);
+	ivec3 texDim = textureSize(u_SlopeMap, 0);
 	if (texDim.x == 0 || texDim.y == 0)
-	{
-		slopes = vec2(0.0);
-		return vec3(0.0, 1.0, 0.0);
-	}
+		return vec3(0.0, 0.0, 1.0);
 
-	float slopeX = texture(u_SlopeXMap, uv).r;
-	float slopeZ = texture(u_SlopeZMap, uv).r;
-	slopes = vec2(slopeX, slopeZ);
+	vec3 sum = vec3(0.0, 0.0, 1.0);
+	for (int c = 0; c < u_CascadeCount; ++c)
+		sum += texture(u_SlopeMap, cascadeCoord(uv, c)).xyz - vec3(0.0, 0.0, 1.0);
+	return sum;
+}
 
-	vec3 normal = vec3(-u_Amplitude * slopeX, 1.0, -u_Amplitude * slopeZ);
+// Derive per-fragment normal directly from the summed slopes.
+vec3 computeWaveNormal(vec2 slopes)
+{
+	vec3 normal = vec3(-u_Amplitude * slopes.x, 1.0, -u_Amplitude * slopes.y);
 	return normalize(normal);
 }
 
 void main(void)
 {
 	vec3 lightDir = normalize(lightDirection);
-	vec2 slopes;
-	vec3 normal = computeWaveNormal(pass_TexCoord, slopes);
+	vec3 slopesJacobian = sampleSlopes(pass_TexCoord);
+	vec3 normal = computeWaveNormal(slopesJacobian.xy);
 	vec3 viewDir = normalize(camPos - pass_Position);
 	vec3 reflectionDir = reflect(-viewDir, normal);
 	vec3 envColor = texture(u_Skybox, reflectionDir).rgb;
@@ -122,7 +133,7 @@ void main(void)
 	vec3 finalColor = specular + scattering;
 	finalColor += envColorSun * fresnel;
 
-	float jacobian = texture(u_JacobianMap, pass_TexCoord).r;
+	float jacobian = slopesJacobian.z;
 	float compression = saturate(1.0 - jacobian);
 	float compressionMask = smoothstep(foamCompressionStart, foamCompressionEnd, compression);
 
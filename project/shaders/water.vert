@@ -1,21 +1,24 @@
 #version 150
 
-in vec3 in_Position;
-in vec2 in_TexCoord;
-
 uniform mat4 projection;
 uniform mat4 view;
 
-// FFT output textures
-uniform sampler2D u_HeightMap;   // H(x, t) - vertical displacement
-uniform sampler2D u_DispX;       // D_x(x, t) - horizontal displacement X
-uniform sampler2D u_DispZ;       // D_z(x, t) - horizontal displacement Z
-uniform sampler2D u_SlopeXMap;   // ∂h/∂x
-uniform sampler2D u_SlopeZMap;   // ∂h/∂z
+// Packed FFT output (kOceanOutputPacked), one layer per cascade:
+// (D_x(x, t), H(x, t), D_z(x, t)) - horizontal X, vertical and horizontal Z displacement
+uniform sampler2DArray u_Displacement;
+
+#define MAX_CASCADES 4
 
 uniform float u_GridSize;        // world-space size of ocean patch
 uniform float u_Amplitude;
 uniform float u_Choppiness;      // scales horizontal displacement strength
+uniform int u_CascadeCount;
+uniform float u_CascadeSizes[MAX_CASCADES]; // world size of each cascade's patch
+
+// Clipmap level being drawn (see Scene_DrawWater)
+uniform vec2 u_LevelOrigin;      // world xz of the level centre, a multiple of twice the cell size
+uniform float u_LevelCellSize;
+uniform int u_GridHalfCells;     // grid is (2R + 1)^2 vertices, gl_VertexID row-major
 
 out vec2 pass_TexCoord;
 out vec3 pass_Position;
@@ -23,17 +26,38 @@ out vec3 worldPos;
 
 void main()
 {
-    vec2 uv = in_TexCoord * u_GridSize / 512.0;
+    int vertsPerSide = 2 * u_GridHalfCells + 1;
+    ivec2 g = ivec2(gl_VertexID % vertsPerSide, gl_VertexID / vertsPerSide) - u_GridHalfCells;
+
+    // Odd vertices on the outer edge collapse onto their even neighbour so the edge matches the
+    // coarser level's vertices exactly (no T-junction cracks once displaced)
+    if (abs(g.x) == u_GridHalfCells && (g.y & 1) != 0)
+        g.y -= 1;
+    if (abs(g.y) == u_GridHalfCells && (g.x & 1) != 0)
+        g.x -= 1;
+    vec2 worldXZ = u_LevelOrigin + vec2(g) * u_LevelCellSize;
+    vec2 uv = worldXZ / u_GridSize;
+
+    // Sum the cascades; each tiles with its own patch size over the same world position
+    vec3 d = vec3(0.0);
+    for (int c = 0; c < u_CascadeCount; ++c)
+    {
+        vec3 uvc = vec3(uv * (u_CascadeSizes[0] / u_CascadeSizes[c]), float(c));
+        d += texture(u_Displacement, uvc).xyz;
+    }
+    float h = d.y;
+    float dx = d.x;
+    float dz = d.z;
 
     // Height
-    float h = texture(u_HeightMap, uv).r * u_Amplitude;
+    h *= u_Amplitude;
 
     // Horizontal displacement (must also be scaled)
-    float dispX = -texture(u_DispX, uv).r * u_Amplitude * u_Choppiness;
-    float dispZ = -texture(u_DispZ, uv).r * u_Amplitude * u_Choppiness;
+    float dispX = -dx * u_Amplitude * u_Choppiness;
+    float dispZ = -dz * u_Amplitude * u_Choppiness;
 
     // WORLD-SPACE position BEFORE displacement
-    vec3 basePos = in_Position;
+    vec3 basePos = vec3(worldXZ.x, 0.0, worldXZ.y);
 
     // Apply horizontal + vertical displacement
     vec3 displaced = vec3(
@@ -42,10 +66,6 @@ void main()
         basePos.z + dispZ
     );
 
-    // Normals (from slopes)
-    float sx = texture(u_SlopeXMap, uv).r; 
-    float sz = texture(u_SlopeZMap, uv).r;
-
     pass_Position = displaced;
     worldPos      = displaced;
     pass_TexCoord = uv;
@@ -107,6 +107,11 @@ void Camera_HandleInput(float delta)
     }
 }
 
+vec3 Camera_GetPosition()
+{
+    return camPos;
+}
+
 void Camera_UpdateViewUniforms(GLuint program, GLuint waterProgram, GLuint skyboxProgram, mat4 projection)
 {
     mat4 view = lookAt(camPos, camPos + camFront, camUp);
@@ -0,0 +1,813 @@
+#include "fft_cpu.h"
+#include "thread_pool.h"
+
+#include <stdio.h>
+#include <math.h>
+#include <string.h>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#elif defined(__SSE3__)
+#include <pmmintrin.h>
+#endif
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+// The transform works on groups of four complex values (four rows or four columns at a time),
+// stored interleaved (re0 im0 re1 im1 ...). Each butterfly then processes four independent
+// sequences with one set of SIMD instructions, and the twiddle of a butterfly is a broadcast.
+static const int kLanes = 4;
+
+#if defined(__AVX__)
+
+typedef __m256 CVec;
+
+struct CTwiddle
+{
+    __m256 re, im;
+};
+
+static inline CTwiddle makeTwiddle(float re, float im) { return {_mm256_set1_ps(re), _mm256_set1_ps(im)}; }
+static inline CVec cvLoad(const float *p) { return _mm256_loadu_ps(p); }
+static inline void cvStore(float *p, CVec v) { _mm256_storeu_ps(p, v); }
+static inline CVec cvAdd(CVec a, CVec b) { return _mm256_add_ps(a, b); }
+static inline CVec cvSub(CVec a, CVec b) { return _mm256_sub_ps(a, b); }
+
+static inline CVec cvMul(CVec a, const CTwiddle &w)
+{
+    CVec swapped = _mm256_permute_ps(a, 0xB1);
+#if defined(__FMA__)
+    return _mm256_fmaddsub_ps(a, w.re, _mm256_mul_ps(swapped, w.im));
+#else
+    return _mm256_addsub_ps(_mm256_mul_ps(a, w.re), _mm256_mul_ps(swapped, w.im));
+#endif
+}
+
+// a * i
+static inline CVec cvMulI(CVec a)
+{
+    const CVec negRe = _mm256_setr_ps(-0.0f, 0.0f, -0.0f, 0.0f, -0.0f, 0.0f, -0.0f, 0.0f);
+    return _mm256_xor_ps(_mm256_permute_ps(a, 0xB1), negRe);
+}
+
+// Transpose a 4x4 block of complex values (row i of the block lives in vector i).
+static inline void cvTranspose4(CVec &a, CVec &b, CVec &c, CVec &d)
+{
+    __m256d t0 = _mm256_unpacklo_pd(_mm256_castps_pd(a), _mm256_castps_pd(b));
+    __m256d t1 = _mm256_unpackhi_pd(_mm256_castps_pd(a), _mm256_castps_pd(b));
+    __m256d t2 = _mm256_unpacklo_pd(_mm256_castps_pd(c), _mm256_castps_pd(d));
+    __m256d t3 = _mm256_unpackhi_pd(_mm256_castps_pd(c), _mm256_castps_pd(d));
+    a = _mm256_castpd_ps(_mm256_permute2f128_pd(t0, t2, 0x20));
+    b = _mm256_castpd_ps(_mm256_permute2f128_pd(t1, t3, 0x20));
+    c = _mm256_castpd_ps(_mm256_permute2f128_pd(t0, t2, 0x31));
+    d = _mm256_castpd_ps(_mm256_permute2f128_pd(t1, t3, 0x31));
+}
+
+#elif defined(__SSE3__)
+
+struct CVec
+{
+    __m128 lo, hi;
+};
+
+struct CTwiddle
+{
+    __m128 re, im;
+};
+
+static inline CTwiddle makeTwiddle(float re, float im) { return {_mm_set1_ps(re), _mm_set1_ps(im)}; }
+static inline CVec cvLoad(const float *p) { return {_mm_loadu_ps(p), _mm_loadu_ps(p + 4)}; }
+static inline void cvStore(float *p, CVec v)
+{
+    _mm_storeu_ps(p, v.lo);
+    _mm_storeu_ps(p + 4, v.hi);
+}
+static inline CVec cvAdd(CVec a, CVec b) { return {_mm_add_ps(a.lo, b.lo), _mm_add_ps(a.hi, b.hi)}; }
+static inline CVec cvSub(CVec a, CVec b) { return {_mm_sub_ps(a.lo, b.lo), _mm_sub_ps(a.hi, b.hi)}; }
+
+static inline __m128 mulHalf(__m128 a, const CTwiddle &w)
+{
+    __m128 swapped = _mm_shuffle_ps(a, a, _MM_SHUFFLE(2, 3, 0, 1));
+    return _mm_addsub_ps(_mm_mul_ps(a, w.re), _mm_mul_ps(swapped, w.im));
+}
+
+static inline CVec cvMul(CVec a, const CTwiddle &w) { return {mulHalf(a.lo, w), mulHalf(a.hi, w)}; }
+
+static inline CVec cvMulI(CVec a)
+{
+    const __m128 negRe = _mm_setr_ps(-0.0f, 0.0f, -0.0f, 0.0f);
+    return {_mm_xor_ps(_mm_shuffle_ps(a.lo, a.lo, _MM_SHUFFLE(2, 3, 0, 1)), negRe),
+            _mm_xor_ps(_mm_shuffle_ps(a.hi, a.hi, _MM_SHUFFLE(2, 3, 0, 1)), negRe)};
+}
+
+static inline void cvTranspose4(CVec &a, CVec &b, CVec &c, CVec &d)
+{
+    CVec ra = {_mm_movelh_ps(a.lo, b.lo), _mm_movelh_ps(c.lo, d.lo)};
+    CVec rb = {_mm_movehl_ps(b.lo, a.lo), _mm_movehl_ps(d.lo, c.lo)};
+    CVec rc = {_mm_movelh_ps(a.hi, b.hi), _mm_movelh_ps(c.hi, d.hi)};
+    CVec rd = {_mm_movehl_ps(b.hi, a.hi), _mm_movehl_ps(d.hi, c.hi)};
+    a = ra;
+    b = rb;
+    c = rc;
+    d = rd;
+}
+
+#else
+
+// Portable fallback; plain loops the compiler is free to auto-vectorize.
+struct CVec
+{
+    float v[8];
+};
+
+struct CTwiddle
+{
+    float re, im;
+};
+
+static inline CTwiddle makeTwiddle(float re, float im) { return {re, im}; }
+static inline CVec cvLoad(const float *p)
+{
+    CVec r;
+    memcpy(r.v, p, sizeof(r.v));
+    return r;
+}
+static inline void cvStore(float *p, CVec v) { memcpy(p, v.v, sizeof(v.v)); }
+static inline CVec cvAdd(CVec a, CVec b)
+{
+    for (int i = 0; i < 8; ++i)
+        a.v[i] += b.v[i];
+    return a;
+}
+static inline CVec cvSub(CVec a, CVec b)
+{
+    for (int i = 0; i < 8; ++i)
+        a.v[i] -= b.v[i];
+    return a;
+}
+static inline CVec cvMul(CVec a, const CTwiddle &w)
+{
+    CVec r;
+    for (int i = 0; i < 8; i += 2)
+    {
+        r.v[i] = a.v[i] * w.re - a.v[i + 1] * w.im;
+        r.v[i + 1] = a.v[i] * w.im + a.v[i + 1] * w.re;
+    }
+    return r;
+}
+static inline CVec cvMulI(CVec a)
+{
+    CVec r;
+    for (int i = 0; i < 8; i += 2)
+    {
+        r.v[i] = -a.v[i + 1];
+        r.v[i + 1] = a.v[i];
+    }
+    return r;
+}
+static inline void cvTranspose4(CVec &a, CVec &b, CVec &c, CVec &d)
+{
+    CVec *rows[4] = {&a, &b, &c, &d};
+    for (int i = 0; i < 4; ++i)
+    {
+        for (int j = i + 1; j < 4; ++j)
+        {
+            std::swap(rows[i]->v[2 * j], rows[j]->v[2 * i]);
+            std::swap(rows[i]->v[2 * j + 1], rows[j]->v[2 * i + 1]);
+        }
+    }
+}
+
+#endif
+
+// One Stockham autosort step: n = radix * m remaining length, s = stride of already finished digits.
+struct FFTStageCPU
+{
+    int radix;
+    int m;
+    int s;
+    int twiddleOffset; // float offset into FFTAxisCPU::twiddles, (radix - 1) pairs per p
+};
+
+struct FFTAxisCPU
+{
+    int length = 0;
+    std::vector<FFTStageCPU> stages;
+    std::vector<float> twiddles;
+};
+
+struct FFTPlanCPU
+{
+    int W = 0;
+    int H = 0;
+    bool vectorized = false; // both sides >= kLanes, otherwise the scalar fallback runs
+    FFTAxisCPU rows;         // length W, contiguous
+    FFTAxisCPU cols;         // length H, stride W
+    FFTAxisCPU halfRows;     // length W/2, complex-to-real rows
+    std::vector<float> c2rTwiddles; // e^{i*pi*u/(W/2)}, u < W/2
+    bool c2rVectorized = false;     // W/2 and H >= kLanes
+    CVec *scratch = nullptr; // per worker: two ping-pong buffers of max(W, H) lane groups
+    int scratchWorkers = 0;
+
+    ~FFTPlanCPU() { delete[] scratch; }
+};
+
+static inline bool isPowerOfTwo(int value)
+{
+    return value > 0 && (value & (value - 1)) == 0;
+}
+
+static inline int ilog2i(int value)
+{
+    int result = 0;
+    while (value > 1)
+    {
+        value >>= 1;
+        ++result;
+    }
+    return result;
+}
+
+// Radix schedule: radix-8 steps, with one radix-4 or radix-2 step first for the leftover bits.
+static void buildAxis(FFTAxisCPU &axis, int length)
+{
+    axis.length = length;
+    axis.stages.clear();
+    axis.twiddles.clear();
+
+    std::vector<int> radices;
+    int bits = ilog2i(length);
+    if (bits % 3 == 1)
+        radices.push_back(2);
+    else if (bits % 3 == 2)
+        radices.push_back(4);
+    for (int i = 0; i < bits / 3; ++i)
+        radices.push_back(8);
+
+    int n = length;
+    int s = 1;
+    for (int radix : radices)
+    {
+        FFTStageCPU stage;
+        stage.radix = radix;
+        stage.m = n / radix;
+        stage.s = s;
+        stage.twiddleOffset = static_cast<int>(axis.twiddles.size());
+        // Inverse transform: W_n^{jp} = exp(+2*pi*i*j*p/n), evaluated in double precision.
+        for (int p = 0; p < stage.m; ++p)
+        {
+            for (int j = 1; j < radix; ++j)
+            {
+                double angle = 2.0 * M_PI * static_cast<double>(j) * static_cast<double>(p) / static_cast<double>(n);
+                axis.twiddles.push_back(static_cast<float>(cos(angle)));
+                axis.twiddles.push_back(static_cast<float>(sin(angle)));
+            }
+        }
+        axis.stages.push_back(stage);
+        n = stage.m;
+        s *= radix;
+    }
+}
+
+static void radix2Stage(const CVec *x, CVec *y, int m, int s, const float *tw)
+{
+    const int sm = s * m;
+    for (int p = 0; p < m; ++p)
+    {
+        const CVec *in = x + p * s;
+        CVec *out = y + 2 * p * s;
+        const CTwiddle w1 = makeTwiddle(tw[2 * p], tw[2 * p + 1]);
+        for (int q = 0; q < s; ++q)
+        {
+            CVec a0 = in[q];
+            CVec a1 = in[q + sm];
+            out[q] = cvAdd(a0, a1);
+            out[q + s] = (p == 0) ? cvSub(a0, a1) : cvMul(cvSub(a0, a1), w1);
+        }
+    }
+}
+
+static void radix4Stage(const CVec *x, CVec *y, int m, int s, const float *tw)
+{
+    const int sm = s * m;
+    for (int p = 0; p < m; ++p)
+    {
+        const CVec *in = x + p * s;
+        CVec *out = y + 4 * p * s;
+        const float *t = tw + 6 * p;
+        const CTwiddle w1 = makeTwiddle(t[0], t[1]);
+        const CTwiddle w2 = makeTwiddle(t[2], t[3]);
+        const CTwiddle w3 = makeTwiddle(t[4], t[5]);
+        for (int q = 0; q < s; ++q)
+        {
+            CVec a0 = in[q];
+            CVec a1 = in[q + sm];
+            CVec a2 = in[q + 2 * sm];
+            CVec a3 = in[q + 3 * sm];
+
+            CVec s02 = cvAdd(a0, a2);
+            CVec d02 = cvSub(a0, a2);
+            CVec s13 = cvAdd(a1, a3);
+            CVec d13 = cvMulI(cvSub(a1, a3));
+
+            CVec b0 = cvAdd(s02, s13);
+            CVec b1 = cvAdd(d02, d13);
+            CVec b2 = cvSub(s02, s13);
+            CVec b3 = cvSub(d02, d13);
+
+            out[q] = b0;
+            if (p == 0)
+            {
+                out[q + s] = b1;
+                out[q + 2 * s] = b2;
+                out[q + 3 * s] = b3;
+            }
+            else
+            {
+                out[q + s] = cvMul(b1, w1);
+                out[q + 2 * s] = cvMul(b2, w2);
+                out[q + 3 * s] = cvMul(b3, w3);
+            }
+        }
+    }
+}
+
+static void radix8Stage(const CVec *x, CVec *y, int m, int s, const float *tw)
+{
+    const float r = 0.70710678118654752440f;
+    const CTwiddle w8_1 = makeTwiddle(r, r);  // exp(+i*pi/4)
+    const CTwiddle w8_3 = makeTwiddle(-r, r); // exp(+3i*pi/4)
+    const int sm = s * m;
+    for (int p = 0; p < m; ++p)
+    {
+        const CVec *in = x + p * s;
+        CVec *out = y + 8 * p * s;
+        const float *t = tw + 14 * p;
+        CTwiddle w[7];
+        for (int j = 0; j < 7; ++j)
+            w[j] = makeTwiddle(t[2 * j], t[2 * j + 1]);
+
+        for (int q = 0; q < s; ++q)
+        {
+            CVec a0 = in[q];
+            CVec a1 = in[q + sm];
+            CVec a2 = in[q + 2 * sm];
+            CVec a3 = in[q + 3 * sm];
+            CVec a4 = in[q + 4 * sm];
+            CVec a5 = in[q + 5 * sm];
+            CVec a6 = in[q + 6 * sm];
+            CVec a7 = in[q + 7 * sm];
+
+            // Radix-2 over (k, k + 4), then radix-4 over even and odd inputs.
+            CVec t0 = cvAdd(a0, a4);
+            CVec t1 = cvSub(a0, a4);
+            CVec t2 = cvAdd(a2, a6);
+            CVec t3 = cvMulI(cvSub(a2, a6));
+            CVec t4 = cvAdd(a1, a5);
+            CVec t5 = cvSub(a1, a5);
+            CVec t6 = cvAdd(a3, a7);
+            CVec t7 = cvMulI(cvSub(a3, a7));
+
+            CVec e0 = cvAdd(t0, t2);
+            CVec e1 = cvAdd(t1, t3);
+            CVec e2 = cvSub(t0, t2);
+            CVec e3 = cvSub(t1, t3);
+
+            CVec o0 = cvAdd(t4, t6);
+            CVec o1 = cvMul(cvAdd(t5, t7), w8_1);
+            CVec o2 = cvMulI(cvSub(t4, t6));
+            CVec o3 = cvMul(cvSub(t5, t7), w8_3);
+
+            CVec b[8];
+            b[0] = cvAdd(e0, o0);
+            b[1] = cvAdd(e1, o1);
+            b[2] = cvAdd(e2, o2);
+            b[3] = cvAdd(e3, o3);
+            b[4] = cvSub(e0, o0);
+            b[5] = cvSub(e1, o1);
+            b[6] = cvSub(e2, o2);
+            b[7] = cvSub(e3, o3);
+
+            out[q] = b[0];
+            if (p == 0)
+            {
+                for (int j = 1; j < 8; ++j)
+                    out[q + j * s] = b[j];
+            }
+            else
+            {
+                for (int j = 1; j < 8; ++j)
+                    out[q + j * s] = cvMul(b[j], w[j - 1]);
+            }
+        }
+    }
+}
+
+// Runs all Stockham steps of one axis on kLanes sequences at once. Returns the buffer holding the result.
+static CVec *runAxis(const FFTAxisCPU &axis, CVec *x, CVec *y)
+{
+    for (const FFTStageCPU &stage : axis.stages)
+    {
+        const float *tw = axis.twiddles.data() + stage.twiddleOffset;
+        switch (stage.radix)
+        {
+        case 8:
+            radix8Stage(x, y, stage.m, stage.s, tw);
+            break;
+        case 4:
+            radix4Stage(x, y, stage.m, stage.s, tw);
+            break;
+        default:
+            radix2Stage(x, y, stage.m, stage.s, tw);
+            break;
+        }
+        std::swap(x, y);
+    }
+    return x;
+}
+
+// Rows [4*g0, 4*g1): 4x4 transposes gather four rows into one lane group and scatter them back.
+static void transformRows(const FFTPlanCPU *plan, Complex *data, int g0, int g1, CVec *x, CVec *y)
+{
+    const int W = plan->W;
+    float *base = reinterpret_cast<float *>(data);
+    for (int g = g0; g < g1; ++g)
+    {
+        float *r0 = base + 2 * static_cast<size_t>(g * kLanes) * W;
+        float *r1 = r0 + 2 * W;
+        float *r2 = r1 + 2 * W;
+        float *r3 = r2 + 2 * W;
+        for (int i = 0; i < W; i += kLanes)
+        {
+            CVec a = cvLoad(r0 + 2 * i);
+            CVec b = cvLoad(r1 + 2 * i);
+            CVec c = cvLoad(r2 + 2 * i);
+            CVec d = cvLoad(r3 + 2 * i);
+            cvTranspose4(a, b, c, d);
+            x[i] = a;
+            x[i + 1] = b;
+            x[i + 2] = c;
+            x[i + 3] = d;
+        }
+        CVec *result = runAxis(plan->rows, x, y);
+        for (int i = 0; i < W; i += kLanes)
+        {
+            CVec a = result[i];
+            CVec b = result[i + 1];
+            CVec c = result[i + 2];
+            CVec d = result[i + 3];
+            cvTranspose4(a, b, c, d);
+            cvStore(r0 + 2 * i, a);
+            cvStore(r1 + 2 * i, b);
+            cvStore(r2 + 2 * i, c);
+            cvStore(r3 + 2 * i, d);
+        }
+    }
+}
+
+// `lanes` (<= kLanes) adjacent columns starting at col, rowStride complex apart. Adjacent columns
+// are contiguous, so each element is a plain load; a partial group goes through a padded copy.
+static void transformColumnGroup(const FFTAxisCPU &axis, float *col, size_t rowStride, int lanes, CVec *x, CVec *y)
+{
+    const int H = axis.length;
+    if (lanes == kLanes)
+    {
+        for (int j = 0; j < H; ++j)
+            x[j] = cvLoad(col + 2 * j * rowStride);
+        CVec *result = runAxis(axis, x, y);
+        for (int j = 0; j < H; ++j)
+            cvStore(col + 2 * j * rowStride, result[j]);
+        return;
+    }
+
+    float lane[2 * kLanes] = {};
+    for (int j = 0; j < H; ++j)
+    {
+        memcpy(lane, col + 2 * j * rowStride, 2 * lanes * sizeof(float));
+        x[j] = cvLoad(lane);
+    }
+    CVec *result = runAxis(axis, x, y);
+    for (int j = 0; j < H; ++j)
+    {
+        cvStore(lane, result[j]);
+        memcpy(col + 2 * j * rowStride, lane, 2 * lanes * sizeof(float));
+    }
+}
+
+// Columns [4*g0, 4*g1).
+static void transformColumns(const FFTPlanCPU *plan, Complex *data, int g0, int g1, CVec *x, CVec *y)
+{
+    float *base = reinterpret_cast<float *>(data);
+    for (int g = g0; g < g1; ++g)
+        transformColumnGroup(plan->cols, base + 2 * g * kLanes, plan->W, kLanes, x, y);
+}
+
+// Complex-to-real rows [4*g0, 4*g1): each row of W/2 + 1 bins Y becomes Z[u] = E[u] + i*O[u] with
+// E[u] = Y[u] + conj(Y[W/2-u]), O[u] = (Y[u] - conj(Y[W/2-u])) * e^{i*pi*u/(W/2)}. The length W/2
+// inverse transform of Z holds the even outputs in .x and the odd ones in .y, i.e. the real row.
+static void transformC2RRows(const FFTPlanCPU *plan, const Complex *half, float *out, int g0, int g1, CVec *x, CVec *y)
+{
+    const int W = plan->W;
+    const int halfW = W / 2;
+    const int bins = halfW + 1;
+    const float *tw = plan->c2rTwiddles.data();
+    Complex *z = reinterpret_cast<Complex *>(y); // kLanes rows of halfW, consumed before runAxis
+    for (int g = g0; g < g1; ++g)
+    {
+        for (int r = 0; r < kLanes; ++r)
+        {
+            const Complex *Y = half + static_cast<size_t>(g * kLanes + r) * bins;
+            Complex *Z = z + r * halfW;
+            for (int u = 0; u < halfW; ++u)
+            {
+                Complex a = Y[u];
+                Complex b = {Y[halfW - u].x, -Y[halfW - u].y};
+                Complex e = {a.x + b.x, a.y + b.y};
+                Complex d = {a.x - b.x, a.y - b.y};
+                Complex o = {d.x * tw[2 * u] - d.y * tw[2 * u + 1], d.x * tw[2 * u + 1] + d.y * tw[2 * u]};
+                Z[u] = {e.x - o.y, e.y + o.x};
+            }
+        }
+
+        const float *z0 = reinterpret_cast<const float *>(z);
+        for (int i = 0; i < halfW; i += kLanes)
+        {
+            CVec a = cvLoad(z0 + 2 * i);
+            CVec b = cvLoad(z0 + 2 * (halfW + i));
+            CVec c = cvLoad(z0 + 2 * (2 * halfW + i));
+            CVec d = cvLoad(z0 + 2 * (3 * halfW + i));
+            cvTranspose4(a, b, c, d);
+            x[i] = a;
+            x[i + 1] = b;
+            x[i + 2] = c;
+            x[i + 3] = d;
+        }
+        CVec *result = runAxis(plan->halfRows, x, y);
+
+        float *r0 = out + static_cast<size_t>(g * kLanes) * W;
+        for (int i = 0; i < halfW; i += kLanes)
+        {
+            CVec a = result[i];
+            CVec b = result[i + 1];
+            CVec c = result[i + 2];
+            CVec d = result[i + 3];
+            cvTranspose4(a, b, c, d);
+            cvStore(r0 + 2 * i, a);
+            cvStore(r0 + W + 2 * i, b);
+            cvStore(r0 + 2 * W + 2 * i, c);
+            cvStore(r0 + 3 * W + 2 * i, d);
+        }
+    }
+}
+
+// Scalar radix-2 for degenerate shapes (a side shorter than kLanes).
+static void scalarIFFT1D(Complex *data, int length, int stride, std::vector<Complex> &tmp)
+{
+    const int bits = ilog2i(length);
+    tmp.resize(length);
+    for (int i = 0; i < length; ++i)
+    {
+        int rev = 0;
+        for (int b = 0; b < bits; ++b)
+            rev |= ((i >> b) & 1) << (bits - 1 - b);
+        tmp[rev] = data[static_cast<size_t>(i) * stride];
+    }
+    for (int size = 2; size <= length; size <<= 1)
+    {
+        const int half = size / 2;
+        for (int start = 0; start < length; start += size)
+        {
+            for (int k = 0; k < half; ++k)
+            {
+                double angle = 2.0 * M_PI * k / size;
+                float wr = static_cast<float>(cos(angle));
+                float wi = static_cast<float>(sin(angle));
+                Complex a = tmp[start + k];
+                Complex b = tmp[start + k + half];
+                Complex t = {b.x * wr - b.y * wi, b.x * wi + b.y * wr};
+                tmp[start + k] = {a.x + t.x, a.y + t.y};
+                tmp[start + k + half] = {a.x - t.x, a.y - t.y};
+            }
+        }
+    }
+    for (int i = 0; i < length; ++i)
+        data[static_cast<size_t>(i) * stride] = tmp[i];
+}
+
+FFTPlanCPU *createFFTPlanCPU(int W, int H)
+{
+    if (!isPowerOfTwo(W) || !isPowerOfTwo(H))
+    {
+        printf("CPU FFT dimensions must be powers of two (got %d x %d).\n", W, H);
+        return nullptr;
+    }
+    FFTPlanCPU *plan = new FFTPlanCPU();
+    plan->W = W;
+    plan->H = H;
+    plan->vectorized = W >= kLanes && H >= kLanes;
+    buildAxis(plan->rows, W);
+    buildAxis(plan->cols, H);
+    if (W >= 2)
+    {
+        const int halfW = W / 2;
+        buildAxis(plan->halfRows, halfW);
+        plan->c2rVectorized = halfW >= kLanes && H >= kLanes;
+        for (int u = 0; u < halfW; ++u)
+        {
+            double angle = M_PI * static_cast<double>(u) / static_cast<double>(halfW);
+            plan->c2rTwiddles.push_back(static_cast<float>(cos(angle)));
+            plan->c2rTwiddles.push_back(static_cast<float>(sin(angle)));
+        }
+    }
+    plan->scratch = new CVec[2 * static_cast<size_t>(W > H ? W : H)];
+    plan->scratchWorkers = 1;
+    return plan;
+}
+
+void destroyFFTPlanCPU(FFTPlanCPU *plan)
+{
+    delete plan;
+}
+
+void executeIFFT2DCPU(FFTPlanCPU *plan, Complex *data)
+{
+    if (!plan || !data)
+        return;
+
+    const int W = plan->W;
+    const int H = plan->H;
+    if (!plan->vectorized)
+    {
+        std::vector<Complex> tmp;
+        for (int row = 0; row < H; ++row)
+            scalarIFFT1D(data + static_cast<size_t>(row) * W, W, 1, tmp);
+        for (int col = 0; col < W; ++col)
+            scalarIFFT1D(data + col, H, W, tmp);
+        return;
+    }
+
+    const int maxLength = W > H ? W : H;
+    CVec *x = plan->scratch;
+    CVec *y = x + maxLength;
+    transformRows(plan, data, 0, H / kLanes, x, y);
+    transformColumns(plan, data, 0, W / kLanes, x, y);
+}
+
+void executeIFFT2DBatchCPU(FFTPlanCPU *plan, Complex *data, int count, ThreadPool *pool)
+{
+    if (!plan || !data || count < 1)
+        return;
+
+    const int W = plan->W;
+    const int H = plan->H;
+    const size_t fieldSize = static_cast<size_t>(W) * H;
+    if (!plan->vectorized)
+    {
+        for (int field = 0; field < count; ++field)
+            executeIFFT2DCPU(plan, data + field * fieldSize);
+        return;
+    }
+
+    const int maxLength = W > H ? W : H;
+    const int workers = ThreadPool_GetThreadCount(pool);
+    if (plan->scratchWorkers < workers)
+    {
+        delete[] plan->scratch;
+        plan->scratch = new CVec[2 * static_cast<size_t>(maxLength) * workers];
+        plan->scratchWorkers = workers;
+    }
+
+    const int rowGroups = H / kLanes;
+    ThreadPool_ParallelFor(pool, count * rowGroups, 1, [&](int begin, int end, int worker)
+    {
+        CVec *x = plan->scratch + 2 * static_cast<size_t>(maxLength) * worker;
+        for (int task = begin; task < end; ++task)
+        {
+            const int field = task / rowGroups;
+            const int group = task % rowGroups;
+            transformRows(plan, data + field * fieldSize, group, group + 1, x, x + maxLength);
+        }
+    });
+
+    // Two lane groups per chunk so neighbouring threads never write the same cache line.
+    const int colGroups = W / kLanes;
+    ThreadPool_ParallelFor(pool, count * colGroups, 2, [&](int begin, int end, int worker)
+    {
+        CVec *x = plan->scratch + 2 * static_cast<size_t>(maxLength) * worker;
+        for (int task = begin; task < end; ++task)
+        {
+            const int field = task / colGroups;
+            const int group = task % colGroups;
+            transformColumns(plan, data + field * fieldSize, group, group + 1, x, x + maxLength);
+        }
+    });
+}
+
+// Reference path for tiny shapes: rebuild the full Hermitian spectrum and transform it.
+static void scalarC2R2D(const FFTPlanCPU *plan, const Complex *half, float *out)
+{
+    const int W = plan->W;
+    const int H = plan->H;
+    const int bins = W / 2 + 1;
+    std::vector<Complex> full(static_cast<size_t>(W) * H);
+    std::vector<Complex> tmp;
+    for (int v = 0; v < H; ++v)
+    {
+        for (int u = 0; u < W; ++u)
+        {
+            if (u < bins)
+                full[v * W + u] = half[v * bins + u];
+            else
+            {
+                const Complex &m = half[((H - v) % H) * bins + (W - u)];
+                full[v * W + u] = {m.x, -m.y};
+            }
+        }
+    }
+    for (int row = 0; row < H; ++row)
+        scalarIFFT1D(full.data() + static_cast<size_t>(row) * W, W, 1, tmp);
+    for (int col = 0; col < W; ++col)
+        scalarIFFT1D(full.data() + col, H, W, tmp);
+    for (size_t i = 0; i < full.size(); ++i)
+        out[i] = full[i].x;
+}
+
+void executeIFFT2DC2RBatchCPU(FFTPlanCPU *plan, Complex *halfSpectra, float *out, int count, ThreadPool *pool)
+{
+    if (!plan || !halfSpectra || !out || count < 1 || plan->W < 2)
+        return;
+
+    const int W = plan->W;
+    const int H = plan->H;
+    const int bins = W / 2 + 1;
+    const size_t halfSize = static_cast<size_t>(bins) * H;
+    const size_t fieldSize = static_cast<size_t>(W) * H;
+    if (!plan->c2rVectorized)
+    {
+        for (int field = 0; field < count; ++field)
+            scalarC2R2D(plan, halfSpectra + field * halfSize, out + field * fieldSize);
+        return;
+    }
+
+    const int maxLength = W > H ? W : H;
+    const int workers = ThreadPool_GetThreadCount(pool);
+    if (plan->scratchWorkers < workers)
+    {
+        delete[] plan->scratch;
+        plan->scratch = new CVec[2 * static_cast<size_t>(maxLength) * workers];
+        plan->scratchWorkers = workers;
+    }
+
+    // Columns over all W/2 + 1 bins; the last group holds only the Nyquist column.
+    const int colGroups = (bins + kLanes - 1) / kLanes;
+    ThreadPool_ParallelFor(pool, count * colGroups, 2, [&](int begin, int end, int worker)
+    {
+        CVec *x = plan->scratch + 2 * static_cast<size_t>(maxLength) * worker;
+        for (int task = begin; task < end; ++task)
+        {
+            const int field = task / colGroups;
+            const int group = task % colGroups;
+            const int lanes = bins - group * kLanes < kLanes ? bins - group * kLanes : kLanes;
+            float *col = reinterpret_cast<float *>(halfSpectra + field * halfSize) + 2 * group * kLanes;
+            transformColumnGroup(plan->cols, col, bins, lanes, x, x + maxLength);
+        }
+    });
+
+    // Rows of consecutive fields are contiguous in both layouts, so the batch is just more rows.
+    ThreadPool_ParallelFor(pool, count * H / kLanes, 1, [&](int begin, int end, int worker)
+    {
+        CVec *x = plan->scratch + 2 * static_cast<size_t>(maxLength) * worker;
+        transformC2RRows(plan, halfSpectra, out, begin, end, x, x + maxLength);
+    });
+}
+
+// Each calling thread keeps its own plan, freed when the thread exits
+struct FFTPlanCPUDeleter
+{
+    void operator()(FFTPlanCPU *plan) const { destroyFFTPlanCPU(plan); }
+};
+
+bool computeIFFT2DCPU(const Complex *spectrum, Complex *out, int W, int H)
+{
+    thread_local std::unique_ptr<FFTPlanCPU, FFTPlanCPUDeleter> cachedPlan;
+    if (!spectrum || !out)
+    {
+        printf("computeIFFT2DCPU: invalid arguments.\n");
+        return false;
+    }
+    if (!cachedPlan || cachedPlan->W != W || cachedPlan->H != H)
+    {
+        cachedPlan.reset(createFFTPlanCPU(W, H));
+        if (!cachedPlan)
+            return false;
+    }
+    if (out != spectrum)
+        memcpy(out, spectrum, sizeof(Complex) * static_cast<size_t>(W) * H);
+    executeIFFT2DCPU(cachedPlan.get(), out);
+    return true;
+}
@@ -2,21 +2,48 @@
 #include <stdio.h>
 #include <math.h>
 #include <stdlib.h>
+#include <vector>
 
 #ifndef M_PI
 #define M_PI 3.14159265358979323846
 #endif
 
 static GLuint fft2DProgram = 0;
-
+static GLuint fftSharedProgram = 0; // whole-sequence shared-memory Stockham kernel
 
 static const int kFFTLocalSize = 256; // Must match compute shader local_size_x
+static const int kMaxGroupsX = 65535;  // Minimum GL_MAX_COMPUTE_WORK_GROUP_COUNT guaranteed by the spec
+static const int kMaxSharedLength = 2048; // Must match MAX_LENGTH in fft_stockham_shared.comp
 
 static GLint gFFT2DLocLength = -1;
 static GLint gFFT2DLocStride = -1;
 static GLint gFFT2DLocCount = -1;
 static GLint gFFT2DLocStage = -1;
 static GLint gFFT2DLocDir = -1;
+static GLint gFFT2DLocC2R = -1;
+static GLint gFFT2DLocTables = -1;
+static GLint gFFT2DLocHalf = -1;
+
+static GLint gSharedLocLength = -1;
+static GLint gSharedLocStride = -1;
+static GLint gSharedLocCount = -1;
+static GLint gSharedLocDir = -1;
+static GLint gSharedLocC2R = -1;
+static GLint gSharedLocTables = -1;
+static GLint gSharedLocHalf = -1;
+
+// Per-length lookup tables (layout in fft_2d_stage.comp), indexed by log2(length). Built on first
+// use of a length and kept for the life of the process; the 1024-point set is 61 KiB.
+struct FFTTablesGPU
+{
+    GLuint twiddles; // vec2[2 * length - 1]
+    GLuint indices;  // uvec2[(log2(length) + 1) * length / 2]
+};
+static FFTTablesGPU gFFTTables[32];
+static bool gUseFFTTables = true;
+static void (*gPassHook)(FFTAxisGPU axis, bool begin) = nullptr;
+static unsigned gDispatchCount = 0; // running totals for getFFTCountersGPU
+static unsigned gBarrierCount = 0;
 
 static inline bool isPowerOfTwo(int value)
 {
@@ -39,6 +66,28 @@ static inline int ceilDiv(int numerator, int denominator)
     return (numerator + denominator - 1) / denominator;
 }
 
+// Launch `groups` workgroups; large batches spill into the y dimension
+// (the shaders flatten the grid back into one index).
+static void dispatchGroups(int groups)
+{
+    int groupsY = ceilDiv(groups, kMaxGroupsX);
+    int groupsX = ceilDiv(groups, groupsY);
+    glDispatchCompute(groupsX, groupsY, 1);
+    ++gDispatchCount;
+}
+
+// Makes one pass's storage writes visible to the next
+static void storageBarrier()
+{
+    glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+    ++gBarrierCount;
+}
+
+// Launch enough 1D work for `threads` invocations.
+static void dispatchThreads(int threads)
+{
+    dispatchGroups(ceilDiv(threads, kFFTLocalSize));
+}
 
 static bool cacheFFT2DUniforms()
 {
@@ -51,7 +100,11 @@ static bool cacheFFT2DUniforms()
     gFFT2DLocCount = glGetUniformLocation(fft2DProgram, "u_count");
     gFFT2DLocStage = glGetUniformLocation(fft2DProgram, "u_stage");
     gFFT2DLocDir = glGetUniformLocation(fft2DProgram, "u_dir");
-    if (gFFT2DLocLength < 0 || gFFT2DLocStride < 0 || gFFT2DLocCount < 0 || gFFT2DLocStage < 0 || gFFT2DLocDir < 0)
+    gFFT2DLocC2R = glGetUniformLocation(fft2DProgram, "u_c2r");
+    gFFT2DLocTables = glGetUniformLocation(fft2DProgram, "u_tables");
+    gFFT2DLocHalf = glGetUniformLocation(fft2DProgram, "u_half");
+    if (gFFT2DLocLength < 0 || gFFT2DLocStride < 0 || gFFT2DLocCount < 0 || gFFT2DLocStage < 0 || gFFT2DLocDir < 0 ||
+        gFFT2DLocC2R < 0 || gFFT2DLocTables < 0 || gFFT2DLocHalf < 0)
     {
         printf("FFT 2D compute shader missing uniforms.\n");
         return false;
@@ -59,36 +112,171 @@ static bool cacheFFT2DUniforms()
     return true;
 }
 
+static bool cacheSharedUniforms()
+{
+    if (fftSharedProgram == 0)
+        return false;
+    if (gSharedLocLength >= 0)
+        return true;
+    gSharedLocLength = glGetUniformLocation(fftSharedProgram, "u_length");
+    gSharedLocStride = glGetUniformLocation(fftSharedProgram, "u_stride");
+    gSharedLocCount = glGetUniformLocation(fftSharedProgram, "u_count");
+    gSharedLocDir = glGetUniformLocation(fftSharedProgram, "u_dir");
+    gSharedLocC2R = glGetUniformLocation(fftSharedProgram, "u_c2r");
+    gSharedLocTables = glGetUniformLocation(fftSharedProgram, "u_tables");
+    gSharedLocHalf = glGetUniformLocation(fftSharedProgram, "u_half");
+    if (gSharedLocLength < 0 || gSharedLocStride < 0 || gSharedLocCount < 0 || gSharedLocDir < 0 || gSharedLocC2R < 0 ||
+        gSharedLocTables < 0 || gSharedLocHalf < 0)
+    {
+        printf("Shared-memory FFT compute shader missing uniforms.\n");
+        return false;
+    }
+    return true;
+}
+
+// Twiddles e^{i*pi*k/ns} for every span ns = 1..length (computed in double), bit-reversal pairs and
+// the butterfly inputs of each radix-2 stage.
+static const FFTTablesGPU &getFFTTables(int length)
+{
+    FFTTablesGPU &tables = gFFTTables[ilog2i(length)];
+    if (tables.twiddles)
+        return tables;
+
+    const int log2Length = ilog2i(length);
+    const int half = length / 2;
+    std::vector<Complex> twiddles(2 * length - 1);
+    for (int ns = 1; ns <= length; ns <<= 1)
+    {
+        for (int k = 0; k < ns; ++k)
+        {
+            double angle = M_PI * k / ns;
+            twiddles[ns - 1 + k] = {(float)cos(angle), (float)sin(angle)};
+        }
+    }
+
+    std::vector<GLuint> indices(2 * (log2Length + 1) * half);
+    for (int pos = 0; pos < length; ++pos)
+    {
+        GLuint rev = 0;
+        for (int bit = 0, v = pos; bit < log2Length; ++bit, v >>= 1)
+            rev = (rev << 1) | (v & 1);
+        indices[pos] = rev; // pair b = (rev(2b), rev(2b + 1))
+    }
+    for (int stage = 1; stage <= log2Length; ++stage)
+    {
+        const int halfSize = 1 << (stage - 1);
+        for (int b = 0; b < half; ++b)
+        {
+            GLuint i = (b / halfSize) * 2 * halfSize + b % halfSize;
+            indices[2 * (stage * half + b)] = i;
+            indices[2 * (stage * half + b) + 1] = i + halfSize;
+        }
+    }
+
+    glGenBuffers(1, &tables.twiddles);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, tables.twiddles);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(Complex) * twiddles.size(), twiddles.data(), GL_STATIC_DRAW);
+    glGenBuffers(1, &tables.indices);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, tables.indices);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(GLuint) * indices.size(), indices.data(), GL_STATIC_DRAW);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+    return tables;
+}
+
+static void bindFFTTables(int length)
+{
+    const FFTTablesGPU &tables = getFFTTables(length);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, tables.twiddles);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, tables.indices);
+}
+
+void setFFTTablesEnabledGPU(bool enabled)
+{
+    gUseFFTTables = enabled;
+}
+
+void setFFTPassHookGPU(void (*hook)(FFTAxisGPU axis, bool begin))
+{
+    gPassHook = hook;
+}
+
+void getFFTCountersGPU(unsigned *dispatches, unsigned *barriers)
+{
+    *dispatches = gDispatchCount;
+    *barriers = gBarrierCount;
+}
+
+static void passHook(FFTAxisGPU axis, bool begin)
+{
+    if (gPassHook)
+        gPassHook(axis, begin);
+}
+
+static bool useSharedKernel(int length)
+{
+    return length <= kMaxSharedLength && cacheSharedUniforms();
+}
+
+// One 1D pass in a single dispatch: each workgroup loads a sequence from input, runs every
+// stage in shared memory and writes it to output. With c2r set, the rows hold length + 1 bins of a
+// Hermitian spectrum and come out as 2 * length real values. half: buffers hold packHalf2x16 values.
+static GLuint executeSharedPass(GLuint input, GLuint output, int length, int stride, int count, int dir,
+                                bool half, bool c2r = false)
+{
+    if (length < 2 || count < 1)
+        return input;
+
+    glUseProgram(fftSharedProgram);
+    glUniform1i(gSharedLocLength, length);
+    glUniform1i(gSharedLocStride, stride);
+    glUniform1i(gSharedLocCount, count);
+    glUniform1i(gSharedLocDir, dir);
+    glUniform1i(gSharedLocC2R, c2r ? 1 : 0);
+    glUniform1i(gSharedLocTables, gUseFFTTables ? 1 : 0);
+    glUniform1i(gSharedLocHalf, half ? 1 : 0);
+    bindFFTTables(length);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, input);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, output);
+    dispatchGroups(count);
+    storageBarrier();
+    return output;
+}
 
-static GLuint executeFFT2DPass(GLuint readBuffer, GLuint writeBuffer, int length, int stride, int count, int dir)
+// One 1D pass over all sequences. The bit-reversal reads from input (never written), the stages
+// ping-pong between bufferA and bufferB. Returns the buffer holding the result. half and c2r as in
+// executeSharedPass.
+static GLuint executeFFT2DPass(GLuint input, GLuint bufferA, GLuint bufferB, int length, int stride, int count, int dir,
+                               bool half, bool c2r = false)
 {
     if (length < 2 || count < 1)
-        return readBuffer;
+        return input;
 
+    glUseProgram(fft2DProgram);
     glUniform1i(gFFT2DLocLength, length);
     glUniform1i(gFFT2DLocStride, stride);
     glUniform1i(gFFT2DLocCount, count);
     glUniform1i(gFFT2DLocDir, dir);
+    glUniform1i(gFFT2DLocC2R, c2r ? 1 : 0);
+    glUniform1i(gFFT2DLocTables, gUseFFTTables ? 1 : 0);
+    glUniform1i(gFFT2DLocHalf, half ? 1 : 0);
+    bindFFTTables(length);
 
     glUniform1i(gFFT2DLocStage, -1);
-    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, readBuffer);
-    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, writeBuffer);
-    int groups = ceilDiv(length * count, kFFTLocalSize);
-    glDispatchCompute(groups, 1, 1);
-    glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, input);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, bufferA);
+    dispatchThreads(length * count);
+    storageBarrier();
 
-    GLuint src = writeBuffer;
-    GLuint dst = readBuffer;
+    GLuint src = bufferA;
+    GLuint dst = bufferB;
     const int log2Length = ilog2i(length);
     for (int stage = 1; stage <= log2Length; ++stage)
     {
         glUniform1i(gFFT2DLocStage, stage);
         glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, src);
         glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, dst);
-        int threads = (length / 2) * count;
-        groups = ceilDiv(threads, kFFTLocalSize);
-        glDispatchCompute(groups, 1, 1);
-        glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+        dispatchThreads((length / 2) * count);
+        storageBarrier();
         GLuint tmp = src;
         src = dst;
         dst = tmp;
@@ -96,9 +284,11 @@ static GLuint executeFFT2DPass(GLuint readBuffer, GLuint writeBuffer, int length
     return src;
 }
 
-static GLuint runFFT2D(GLuint primary, GLuint scratch, int W, int H, int dir)
+// Rows then columns over `batch` W x H fields stored back to back. input is left untouched;
+// the result is in ping or pong.
+static GLuint runFFT2D(GLuint input, GLuint ping, GLuint pong, int W, int H, int batch, int dir, bool half)
 {
-    if (fft2DProgram == 0 || primary == 0 || scratch == 0 || W < 1 || H < 1)
+    if (fft2DProgram == 0 || input == 0 || ping == 0 || pong == 0 || W < 1 || H < 1 || batch < 1)
         return 0;
     if (!isPowerOfTwo(W) || !isPowerOfTwo(H))
     {
@@ -108,17 +298,59 @@ static GLuint runFFT2D(GLuint primary, GLuint scratch, int W, int H, int dir)
     if (!cacheFFT2DUniforms())
         return 0;
 
-    glUseProgram(fft2DProgram);
+    // Each axis uses the one-dispatch shared-memory kernel when the sequence fits in shared
+    // memory, otherwise the bit-reversal + per-stage kernel.
+    // Rows of consecutive fields are contiguous, so the batch is just more rows.
+    passHook(kFFTAxisRows, true);
+    GLuint current = useSharedKernel(W) ? executeSharedPass(input, ping, W, 1, H * batch, dir, half)
+                                        : executeFFT2DPass(input, ping, pong, W, 1, H * batch, dir, half);
+    passHook(kFFTAxisRows, false);
+    if (current == 0)
+        return 0;
+    GLuint spare = (current == ping) ? pong : ping;
 
-    GLuint current = executeFFT2DPass(primary, scratch, W, 1, H, dir);
+    // The column bit-reversal consumes current before any stage writes to it again.
+    // Columns: the shaders map sequence s to field s / W, column s % W.
+    passHook(kFFTAxisColumns, true);
+    current = useSharedKernel(H) ? executeSharedPass(current, spare, H, W, W * batch, dir, half)
+                                 : executeFFT2DPass(current, spare, current, H, W, W * batch, dir, half);
+    passHook(kFFTAxisColumns, false);
     if (current == 0)
         return 0;
-    GLuint spare = (current == primary) ? scratch : primary;
 
-    current = executeFFT2DPass(current, spare, H, W, W, dir);
+    return current;
+}
+
+// Inverse complex-to-real transform of `batch` half spectra (H rows of W/2 + 1 bins, kx = 0..W/2)
+// stored back to back: columns over all W/2 + 1 bins first, then each row's C2R transform of
+// length W/2. The result holds batch W x H real fields back to back, as floats (pairs of halves
+// with half set).
+static GLuint runC2R2D(GLuint input, GLuint ping, GLuint pong, int W, int H, int batch, bool half)
+{
+    if (fft2DProgram == 0 || input == 0 || ping == 0 || pong == 0 || W < 4 || H < 1 || batch < 1)
+        return 0;
+    if (!isPowerOfTwo(W) || !isPowerOfTwo(H))
+    {
+        printf("FFT 2D dimensions must be powers of two (got %d x %d).\n", W, H);
+        return 0;
+    }
+    if (!cacheFFT2DUniforms())
+        return 0;
+
+    const int halfW = W / 2;
+    const int bins = halfW + 1;
+    passHook(kFFTAxisColumns, true);
+    GLuint current = useSharedKernel(H) ? executeSharedPass(input, ping, H, bins, bins * batch, -1, half)
+                                        : executeFFT2DPass(input, ping, pong, H, bins, bins * batch, -1, half);
+    passHook(kFFTAxisColumns, false);
     if (current == 0)
         return 0;
+    GLuint spare = (current == ping) ? pong : ping;
 
+    passHook(kFFTAxisRows, true);
+    current = useSharedKernel(halfW) ? executeSharedPass(current, spare, halfW, 1, H * batch, -1, half, true)
+                                     : executeFFT2DPass(current, spare, current, halfW, 1, H * batch, -1, half, true);
+    passHook(kFFTAxisRows, false);
     return current;
 }
 
@@ -175,6 +407,108 @@ static void initFFT2DProgram()
             printf("Failed to load 2D FFT compute shader.\n");
         }
     }
+    if (fftSharedProgram == 0)
+    {
+        // Optional: without it every pass uses fft_2d_stage.comp
+        fftSharedProgram = loadComputeShader("shaders/fft_stockham_shared.comp");
+        if (fftSharedProgram == 0)
+        {
+            printf("Shared-memory FFT kernel unavailable, using the multi-pass FFT.\n");
+        }
+    }
+}
+
+// size complex values, packed into one uint each with half
+static GLuint createScratchBuffer(int size, bool half = false)
+{
+    GLuint buffer = 0;
+    glGenBuffers(1, &buffer);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, buffer);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, (half ? sizeof(GLuint) : sizeof(Complex)) * size, NULL, GL_DYNAMIC_COPY);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+    return buffer;
+}
+
+struct FFTPlanGPU
+{
+    int W;
+    int H;
+    int maxBatch;
+    bool realOutput; // scratch sized for executeIFFT2DC2RBatchGPU only
+    bool halfStorage; // packHalf2x16 input, scratch and output
+    GLuint ping;
+    GLuint pong;
+};
+
+FFTPlanGPU *createFFTPlanGPU(int W, int H, int maxBatch, bool realOutput, bool halfStorage)
+{
+    if (maxBatch < 1)
+        maxBatch = 1;
+    if (!isPowerOfTwo(W) || !isPowerOfTwo(H))
+    {
+        printf("createFFTPlanGPU: dimensions must be powers of two (got %d x %d).\n", W, H);
+        return nullptr;
+    }
+    initFFT2DProgram();
+    if (fft2DProgram == 0)
+        return nullptr;
+
+    // Build the lookup tables up front so the first transform does not upload them
+    getFFTTables(W);
+    getFFTTables(H);
+    if (W >= 4)
+        getFFTTables(W / 2);
+
+    FFTPlanGPU *plan = new FFTPlanGPU;
+    plan->W = W;
+    plan->H = H;
+    plan->maxBatch = maxBatch;
+    plan->realOutput = realOutput;
+    plan->halfStorage = halfStorage;
+    // C2R needs H x (W/2 + 1) complex per field: the column pass output is the largest stage
+    const int fieldSize = realOutput ? H * (W / 2 + 1) : W * H;
+    plan->ping = createScratchBuffer(fieldSize * maxBatch, halfStorage);
+    plan->pong = createScratchBuffer(fieldSize * maxBatch, halfStorage);
+    return plan;
+}
+
+void destroyFFTPlanGPU(FFTPlanGPU *plan)
+{
+    if (!plan)
+        return;
+    glDeleteBuffers(1, &plan->ping);
+    glDeleteBuffers(1, &plan->pong);
+    delete plan;
+}
+
+GLuint executeIFFT2DGPU(FFTPlanGPU *plan, GLuint spectrumSSBO)
+{
+    if (!plan || plan->realOutput || spectrumSSBO == 0)
+    {
+        printf("executeIFFT2DGPU: invalid arguments.\n");
+        return 0;
+    }
+    return runFFT2D(spectrumSSBO, plan->ping, plan->pong, plan->W, plan->H, 1, -1, plan->halfStorage);
+}
+
+GLuint executeIFFT2DBatchGPU(FFTPlanGPU *plan, GLuint spectraSSBO, int count)
+{
+    if (!plan || plan->realOutput || spectraSSBO == 0 || count < 1 || count > plan->maxBatch)
+    {
+        printf("executeIFFT2DBatchGPU: invalid arguments.\n");
+        return 0;
+    }
+    return runFFT2D(spectraSSBO, plan->ping, plan->pong, plan->W, plan->H, count, -1, plan->halfStorage);
+}
+
+GLuint executeIFFT2DC2RBatchGPU(FFTPlanGPU *plan, GLuint halfSpectraSSBO, int count)
+{
+    if (!plan || halfSpectraSSBO == 0 || count < 1 || count > plan->maxBatch || plan->W < 4)
+    {
+        printf("executeIFFT2DC2RBatchGPU: invalid arguments.\n");
+        return 0;
+    }
+    return runC2R2D(halfSpectraSSBO, plan->ping, plan->pong, plan->W, plan->H, count, plan->halfStorage);
 }
 
 // Compute 2D inverse FFT: takes spectrum SSBO (row-major kx fastest), runs column then row inverse passes.
@@ -189,23 +523,10 @@ GLuint computeIFFT2D(GLuint spectrumSSBO, int W, int H)
     initFFT2DProgram();
     if (fft2DProgram == 0)
         return 0;
-    int size = W * H;
-    GLuint ssboA = 0, ssboB = 0;
-    glGenBuffers(1, &ssboA);
-    glBindBuffer(GL_SHADER_STORAGE_BUFFER, ssboA);
-    glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(Complex) * size, NULL, GL_DYNAMIC_COPY);
+    GLuint ssboA = createScratchBuffer(W * H);
+    GLuint ssboB = createScratchBuffer(W * H);
 
-    glBindBuffer(GL_COPY_READ_BUFFER, spectrumSSBO);
-    glBindBuffer(GL_COPY_WRITE_BUFFER, ssboA);
-    glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, sizeof(Complex) * size);
-    glBindBuffer(GL_COPY_READ_BUFFER, 0);
-    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
-
-    glGenBuffers(1, &ssboB);
-    glBindBuffer(GL_SHADER_STORAGE_BUFFER, ssboB);
-    glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(Complex) * size, NULL, GL_DYNAMIC_COPY);
-
-    GLuint result = runFFT2D(ssboA, ssboB, W, H, -1);
+    GLuint result = runFFT2D(spectrumSSBO, ssboA, ssboB, W, H, 1, -1, false);
     if (result == 0)
     {
         printf("computeIFFT2D: execution failed.\n");
@@ -221,4 +542,3 @@ GLuint computeIFFT2D(GLuint spectrumSSBO, int W, int H)
 
     return result;
 }
-
@@ -0,0 +1,115 @@
+#include "headless_gl.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+
+#include "GL_utilities.h"
+
+static EGLDisplay gDisplay = EGL_NO_DISPLAY;
+static EGLContext gContext = EGL_NO_CONTEXT;
+static EGLSurface gSurface = EGL_NO_SURFACE;
+
+// Surfaceless Mesa first (render nodes, llvmpipe), then the first EGL device (e.g. NVIDIA headless),
+// then whatever the default display is.
+static EGLDisplay openDisplay()
+{
+    PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay =
+        (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+    PFNEGLQUERYDEVICESEXTPROC queryDevices =
+        (PFNEGLQUERYDEVICESEXTPROC)eglGetProcAddress("eglQueryDevicesEXT");
+
+    EGLint major, minor;
+    if (getPlatformDisplay)
+    {
+        EGLDisplay display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+        if (display != EGL_NO_DISPLAY && eglInitialize(display, &major, &minor))
+            return display;
+
+        EGLDeviceEXT device;
+        EGLint deviceCount = 0;
+        if (queryDevices && queryDevices(1, &device, &deviceCount) && deviceCount > 0)
+        {
+            display = getPlatformDisplay(EGL_PLATFORM_DEVICE_EXT, device, nullptr);
+            if (display != EGL_NO_DISPLAY && eglInitialize(display, &major, &minor))
+                return display;
+        }
+    }
+
+    EGLDisplay display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+    if (display != EGL_NO_DISPLAY && eglInitialize(display, &major, &minor))
+        return display;
+    return EGL_NO_DISPLAY;
+}
+
+bool HeadlessGL_Init(int major, int minor)
+{
+    if (gContext != EGL_NO_CONTEXT)
+        return true;
+
+    gDisplay = openDisplay();
+    if (gDisplay == EGL_NO_DISPLAY)
+    {
+        printf("HeadlessGL_Init: no EGL display available.\n");
+        return false;
+    }
+    if (!eglBindAPI(EGL_OPENGL_API))
+    {
+        printf("HeadlessGL_Init: EGL implementation lacks desktop OpenGL.\n");
+        HeadlessGL_Shutdown();
+        return false;
+    }
+
+    // Compute-only work needs no framebuffer; fall back to a 1x1 pbuffer where a config is required.
+    EGLConfig config = nullptr;
+    const char *extensions = eglQueryString(gDisplay, EGL_EXTENSIONS);
+    bool noConfig = extensions && strstr(extensions, "EGL_KHR_no_config_context") &&
+                    strstr(extensions, "EGL_KHR_surfaceless_context");
+    if (!noConfig)
+    {
+        const EGLint configAttribs[] = {EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+                                        EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+                                        EGL_NONE};
+        EGLint configCount = 0;
+        if (!eglChooseConfig(gDisplay, configAttribs, &config, 1, &configCount) || configCount < 1)
+        {
+            printf("HeadlessGL_Init: no pbuffer-capable EGL config.\n");
+            HeadlessGL_Shutdown();
+            return false;
+        }
+        const EGLint pbufferAttribs[] = {EGL_WIDTH, 1, EGL_HEIGHT, 1, EGL_NONE};
+        gSurface = eglCreatePbufferSurface(gDisplay, config, pbufferAttribs);
+    }
+
+    const EGLint contextAttribs[] = {EGL_CONTEXT_MAJOR_VERSION, major,
+                                     EGL_CONTEXT_MINOR_VERSION, minor,
+                                     EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+                                     EGL_NONE};
+    gContext = eglCreateContext(gDisplay, noConfig ? EGL_NO_CONFIG_KHR : config, EGL_NO_CONTEXT, contextAttribs);
+    if (gContext == EGL_NO_CONTEXT || !eglMakeCurrent(gDisplay, gSurface, gSurface, gContext))
+    {
+        printf("HeadlessGL_Init: could not create a GL %d.%d core context (EGL error 0x%x).\n", major, minor, eglGetError());
+        HeadlessGL_Shutdown();
+        return false;
+    }
+
+    printf("Headless GL: %s, %s\n", (const char *)glGetString(GL_RENDERER), (const char *)glGetString(GL_VERSION));
+    return true;
+}
+
+void HeadlessGL_Shutdown()
+{
+    if (gDisplay == EGL_NO_DISPLAY)
+        return;
+    eglMakeCurrent(gDisplay, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    if (gContext != EGL_NO_CONTEXT)
+        eglDestroyContext(gDisplay, gContext);
+    if (gSurface != EGL_NO_SURFACE)
+        eglDestroySurface(gDisplay, gSurface);
+    eglTerminate(gDisplay);
+    gDisplay = EGL_NO_DISPLAY;
+    gContext = EGL_NO_CONTEXT;
+    gSurface = EGL_NO_SURFACE;
+}
@@ -1,6 +1,9 @@
 #include "ocean.h"
 
 #include <iostream>
+#include <atomic>
+#include <thread>
+#include <cstdio>
 #include <vector>
 #include <chrono>
 #include <algorithm>
@@ -10,12 +13,18 @@
 
 #include "GL_utilities.h"
 #include "fft_gpu.h"
+#include "spsc_queue.h"
 #include "LoadTGA.h"
 
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
 // Forward declarations from ocean_init.cpp (SSBO-based ocean data)
 extern void ocean_init(const OceanInitParams &params);
+extern void ocean_generate_h0(const OceanInitParams &params);
+extern void ocean_release();
 extern GLuint ssboH0; // initial spectrum H0(k)
-extern GLuint ssboHt; // spectrum H(k, t)
 // No CPU-side height buffer when writing directly to textures
 
 // Active configuration used by the compute pipeline.
@@ -25,122 +34,540 @@ static float g_patchSize = 0.0f;         // World size of the simulated ocean pa
 static float g_gravity = 9.81f;          // Gravity passed to compute shaders
 static float g_amplitudeScale = 2500.0f; // Height amplitude scale for water.vert
 static float g_choppiness = 2.2f;        // Tessendorf-style horizontal displacement strength
+static int g_cascadeCount = 1;           // texture array layers / spectra groups
+static float g_cascadeSizes[kOceanMaxCascades] = {}; // domain size per cascade (0 = primary patch)
+static bool g_halfPrecision = false;     // packHalf2x16 spectra and FFT scratch, R16F textures
+static bool g_packedOutput = false;      // kOceanOutputPacked: displacementTex and slopeTex only
 
 // Compute shader programs
-static GLuint evolveProgram = 0;           // evolve spectrum over time
-static GLuint extractProgram = 0;          // extract real height / slope from complex field
-static GLuint slopeSpecProgram = 0;        // build slope spectra from Ht
-static GLuint displacementSpecProgram = 0; // build displacement spectra from Ht
-static GLuint jacobianProgram = 0;         // compute jacobian from displacement field
+static GLuint evolveProgram = 0;           // evolve spectrum over time and build all spectra from it
+static GLuint outputsProgram = 0;          // normalize the FFT output, jacobian, write the textures
 
-// Textures sampled by water.vert
+// Half spectra (N x (N/2 + 1) bins) transformed each frame, stored back to back in ssboSpectra so
+// one batched complex-to-real IFFT covers all of them. Same order as the first OceanField entries;
+// each cascade has its own group of kSpecCount spectra, so every stage runs once for all cascades.
+enum
+{
+    kSpecHeight, // H(k, t)
+    kSpecSlopeX,
+    kSpecSlopeZ,
+    kSpecDispX,
+    kSpecDispZ,
+    kSpecCount
+};
+
+// Persistent per-frame GPU storage, created once in Ocean_Init
+static FFTPlanGPU *g_fftPlan = nullptr; // owns the IFFT ping-pong buffers (kSpecCount fields per cascade)
+static GLuint ssboSpectra = 0;          // kSpecCount half spectra per cascade
+static GLuint ssboDispersion = 0;       // omega = sqrt(g |k|) per H0 bin, rebuilt with the spectrum
+static GLuint ssboPhase = 0;            // (e^{iwt}, e^{iw dt}) per H0 bin, fixed-timestep mode only
+
+// Fixed-timestep phase rotation (Ocean_SetFixedTimestep). Each evolve multiplies the stored phase
+// by e^{iw dt}; the exact phase is recomputed every kPhaseResyncInterval steps to bound the drift.
+static const int kPhaseResyncInterval = 64;
+static float g_fixedTimestep = 0.0f; // seconds, 0 = exact phase every frame
+static int g_phaseSteps = -1;        // rotations since the last exact phase, -1 = stale
+static float g_phaseTime = 0.0f;     // simulation time held in ssboPhase
+static float g_phaseStep = 0.0f;     // simulation step of the stored rotation
+
+// Frame profiler (Ocean_SetStageTiming, Ocean_GetStats). Each update records into one of
+// kOceanStatsLatency query sets: a GL_TIMESTAMP query at the start and end of every stage
+// (timestamps rather than GL_TIME_ELAPSED because llvmpipe reports no elapsed time for compute
+// dispatches). A set is read back when it comes round again, and only if the GPU is done with it.
+struct PendingFrame
+{
+    OceanFrameStats stats;
+    bool issued[kOceanStageCount];
+    bool active; // recorded, not yet published
+};
+static bool g_stageTiming = true;
+static GLuint g_stageQueries[kOceanStatsLatency][2 * kOceanStageCount] = {};
+static PendingFrame g_pendingFrames[kOceanStatsLatency];
+static PendingFrame *g_frame = nullptr; // being recorded, only inside an update
+static int g_lastSet = -1;              // set of the last recorded update
+static uint64_t g_frameNumber = 0;
+static std::chrono::steady_clock::time_point g_stageStart;
+static unsigned g_fftDispatches = 0, g_fftBarriers = 0; // FFT counters when the update started
+
+// Published frames, written by the update thread only. A slot's seq is odd while it is being
+// written and 2 * (n + 1) once it holds the n-th published frame, so readers can detect a slot
+// that was overwritten while they copied it.
+struct StatsSlot
+{
+    std::atomic<uint64_t> seq{0};
+    OceanFrameStats stats;
+};
+static StatsSlot g_statsRing[kOceanStatsFrames];
+static std::atomic<uint64_t> g_statsPublished{0};
+
+// Ocean_SetStatsCSV: a writer thread polls the ring through Ocean_GetStats, so the update never
+// blocks on the file
+static const int kStatsCSVPollMs = 10;
+static FILE *g_statsCSV = nullptr;
+static std::thread g_statsCSVWriter;
+static std::atomic<bool> g_statsCSVQuit{false};
+
+// Parameter deltas pushed from another thread, drained at the start of each update
+static SPSCQueue<OceanParamDelta, 256> g_paramQueue;
+
+// Texture arrays (one layer per cascade) sampled by water.vert/water.frag: the six single-channel
+// arrays of the separate layout, or the two RGBA arrays of the packed one.
 static GLuint heightTex, slopeXTex, slopeZTex, dispXTex, dispZTex, jacobianTex;
+static GLuint displacementTex, slopeTex;
+static GLuint normalTex; // OceanInitParams::normalMap only
+
+GLuint Ocean_GetFieldTexture(OceanField field, int *channel)
+{
+    static const GLuint *kSeparate[kOceanFieldCount] = {
+        &heightTex, &slopeXTex, &slopeZTex, &dispXTex, &dispZTex, &jacobianTex};
+    static const GLuint *kPacked[kOceanFieldCount] = {
+        &displacementTex, &slopeTex, &slopeTex, &displacementTex, &displacementTex, &slopeTex};
+    static const int kPackedChannels[kOceanFieldCount] = {1, 0, 1, 0, 2, 2};
+    if (field < 0 || field >= kOceanFieldCount)
+        return 0;
+    if (channel)
+        *channel = g_packedOutput ? kPackedChannels[field] : 0;
+    return g_packedOutput ? *kPacked[field] : *kSeparate[field];
+}
+
 // Expose texture IDs through public API
-GLuint Ocean_GetHeightTexture() { return heightTex; }
-GLuint Ocean_GetSlopeXTexture() { return slopeXTex; }
-GLuint Ocean_GetSlopeZTexture() { return slopeZTex; }
-GLuint Ocean_GetDispXTexture() { return dispXTex; }
-GLuint Ocean_GetDispZTexture() { return dispZTex; }
-GLuint Ocean_GetJacobianTexture() { return jacobianTex; }
+OceanOutputLayout Ocean_GetOutputLayout() { return g_packedOutput ? kOceanOutputPacked : kOceanOutputSeparate; }
+GLuint Ocean_GetDisplacementTexture() { return displacementTex; }
+GLuint Ocean_GetSlopeTexture() { return slopeTex; }
+GLuint Ocean_GetNormalTexture() { return normalTex; }
+GLuint Ocean_GetHeightTexture() { return Ocean_GetFieldTexture(kOceanFieldHeight); }
+GLuint Ocean_GetSlopeXTexture() { return Ocean_GetFieldTexture(kOceanFieldSlopeX); }
+GLuint Ocean_GetSlopeZTexture() { return Ocean_GetFieldTexture(kOceanFieldSlopeZ); }
+GLuint Ocean_GetDispXTexture() { return Ocean_GetFieldTexture(kOceanFieldDispX); }
+GLuint Ocean_GetDispZTexture() { return Ocean_GetFieldTexture(kOceanFieldDispZ); }
+GLuint Ocean_GetJacobianTexture() { return Ocean_GetFieldTexture(kOceanFieldJacobian); }
 float Ocean_GetPatchSize() { return g_patchSize; }
 float Ocean_GetAmplitudeScale() { return g_amplitudeScale; }
 float Ocean_GetChoppiness() { return g_choppiness; }
 const OceanInitParams &Ocean_GetParams() { return g_oceanParams; }
+int Ocean_GetCascadeCount() { return g_cascadeCount; }
+float Ocean_GetCascadeSize(int cascade) { return cascade >= 0 && cascade < g_cascadeCount ? g_cascadeSizes[cascade] : 0.0f; }
 
-void Texture_Init(GLuint &tex, int width, int height)
+// Reads one channel (0 = red) of every layer of an output texture array as floats
+// (width x height x g_cascadeCount).
+static void ReadTextureLayers(GLuint texture, int channel, float *dst)
 {
-    std::vector<float> zeros(static_cast<size_t>(width) * static_cast<size_t>(height), 0.0f);
-    glGenTextures(1, &tex);
-    glBindTexture(GL_TEXTURE_2D, tex);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-    glTexStorage2D(GL_TEXTURE_2D, 1, GL_R32F, width, height);
-    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height, GL_RED, GL_FLOAT, zeros.data());
+    static const GLenum kChannelFormats[] = {GL_RED, GL_GREEN, GL_BLUE, GL_ALPHA};
+    glBindTexture(GL_TEXTURE_2D_ARRAY, texture);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glGetTexImage(GL_TEXTURE_2D_ARRAY, 0, kChannelFormats[channel], GL_FLOAT, dst);
 }
 
-// Converts complex spectra into time-domain floats and writes directly to textures.
-static void ExtractToTexture(GLuint timeSSBO, GLuint texture)
+void Ocean_ReadField(OceanField field, float *dst, int cascade)
 {
-    if (!extractProgram || !timeSSBO)
+    if (field < 0 || field >= kOceanFieldCount || !dst || g_resolution <= 0 ||
+        cascade < 0 || cascade >= g_cascadeCount)
         return;
+    int channel = 0;
+    GLuint texture = Ocean_GetFieldTexture(field, &channel);
+    if (g_cascadeCount == 1)
+    {
+        ReadTextureLayers(texture, channel, dst);
+        return;
+    }
+    const size_t layerSize = static_cast<size_t>(g_resolution) * g_resolution;
+    std::vector<float> layers(layerSize * g_cascadeCount);
+    ReadTextureLayers(texture, channel, layers.data());
+    memcpy(dst, layers.data() + cascade * layerSize, layerSize * sizeof(float));
+}
 
-    glUseProgram(extractProgram);
-    glUniform1i(glGetUniformLocation(extractProgram, "u_N"), g_resolution);
-    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, timeSSBO);
-    glBindImageTexture(0, texture, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_R32F);
+// Internal format of the output textures, also the image format the compute stages write with
+static GLenum OutputFormat()
+{
+    if (g_packedOutput)
+        return g_halfPrecision ? GL_RGBA16F : GL_RGBA32F;
+    return g_halfPrecision ? GL_R16F : GL_R32F;
+}
 
-    const int total = g_resolution * g_resolution;
-    const int groups = (total + 256 - 1) / 256;
-    glDispatchCompute(groups, 1, 1);
-    glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT | GL_TEXTURE_FETCH_BARRIER_BIT);
+void Texture_Init(GLuint &tex, int width, int height, int layers, GLenum format)
+{
+    std::vector<float> zeros(static_cast<size_t>(width) * static_cast<size_t>(height) * layers * 4, 0.0f);
+    glGenTextures(1, &tex);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, tex);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    glTexStorage3D(GL_TEXTURE_2D_ARRAY, 1, format, width, height, layers);
+    glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, 0, width, height, layers, GL_RGBA, GL_FLOAT, zeros.data());
+}
+
+// Elements in one half spectrum
+static int HalfSpectrumSize()
+{
+    return g_resolution * (g_resolution / 2 + 1);
+}
+
+void Ocean_ReadH0(float *dst)
+{
+    if (!ssboH0 || !dst || g_resolution <= 0)
+        return;
+    glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, ssboH0);
+    glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(float) * 4 * HalfSpectrumSize(), dst);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
 }
 
-// Builds two fields (e.g., Sx/Sz or Dx/Dz) from Ht, IFFT to time domain,
-// and writes the real components directly into textures.
-static void BuildFieldsFromHt(GLuint computeProgram,
-                              GLuint inputHt,
-                              GLuint texA, GLuint texB)
+void Ocean_RegenerateSpectrum(const OceanInitParams &params)
 {
-    if (!computeProgram || !inputHt || g_resolution <= 0)
+    if (!ssboH0 || g_resolution <= 0)
         return;
 
-    const int total = g_resolution * g_resolution;
-    const int groups = (total + 256 - 1) / 256;
-
-    // Allocate temp spectrum SSBOs (complex)
-    GLuint ssboSpecA = 0, ssboSpecB = 0;
-    glGenBuffers(1, &ssboSpecA);
-    glBindBuffer(GL_SHADER_STORAGE_BUFFER, ssboSpecA);
-    glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(Complex) * total, nullptr, GL_DYNAMIC_DRAW);
-    glGenBuffers(1, &ssboSpecB);
-    glBindBuffer(GL_SHADER_STORAGE_BUFFER, ssboSpecB);
-    glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(Complex) * total, nullptr, GL_DYNAMIC_DRAW);
+    // Spectrum shape only; resolution, patch size and the render scales stay as initialized
+    g_oceanParams.windDirection = params.windDirection;
+    g_oceanParams.windSpeed = params.windSpeed;
+    g_oceanParams.alpha = params.alpha;
+    g_oceanParams.gamma = params.gamma;
+    g_oceanParams.spreadExponent = params.spreadExponent;
+    g_oceanParams.lowCutoff = params.lowCutoff;
+    g_oceanParams.highCutoff = params.highCutoff;
+    g_oceanParams.randomSeed = params.randomSeed;
+    ocean_generate_h0(g_oceanParams);
+}
+
+// Uploads omega(k) = sqrt(g |k|) for every half-spectrum bin of every cascade, with the same
+// wave vectors as the spectrum, so the evolve stage does no square roots.
+static void UploadDispersionTable()
+{
+    const int N = g_resolution;
+    const int bins = N / 2 + 1;
+    std::vector<float> omega(static_cast<size_t>(HalfSpectrumSize()) * g_cascadeCount);
+    float *dst = omega.data();
+    for (int c = 0; c < g_cascadeCount; ++c)
+    {
+        const float twoPiOverDomain = static_cast<float>(2.0 * M_PI) / std::max(g_cascadeSizes[c], 1.0f);
+        for (int v = 0; v < N; ++v)
+        {
+            float ky = (v < N / 2 ? v : v - N) * twoPiOverDomain;
+            for (int u = 0; u < bins; ++u)
+            {
+                float kx = (u < N / 2 ? u : u - N) * twoPiOverDomain;
+                *dst++ = std::sqrt(g_gravity * std::sqrt(kx * kx + ky * ky));
+            }
+        }
+    }
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, ssboDispersion);
+    glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(float) * omega.size(), omega.data());
     glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+    g_phaseSteps = -1; // stored phases belong to the old frequencies
+}
 
-    // Build both spectra from Ht
-    glUseProgram(computeProgram);
-    glUniform1i(glGetUniformLocation(computeProgram, "u_N"), g_resolution);
-    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, inputHt);
-    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, ssboSpecA);
-    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, ssboSpecB);
-    glDispatchCompute(groups, 1, 1);
-    glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+void Ocean_SetFixedTimestep(float seconds)
+{
+    g_fixedTimestep = seconds > 0.0f ? seconds : 0.0f;
+    g_phaseSteps = -1;
+}
+
+static void PublishFrame(const OceanFrameStats &stats)
+{
+    const uint64_t index = g_statsPublished.load(std::memory_order_relaxed);
+    StatsSlot &slot = g_statsRing[index % kOceanStatsFrames];
+    slot.seq.store(2 * index + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    slot.stats = stats;
+    slot.seq.store(2 * index + 2, std::memory_order_release);
+    g_statsPublished.store(index + 1, std::memory_order_release);
+}
 
-    // IFFT both spectra to time-domain
-    GLuint ssboTimeA = computeIFFT2D(ssboSpecA, g_resolution, g_resolution);
-    GLuint ssboTimeB = computeIFFT2D(ssboSpecB, g_resolution, g_resolution);
+// Publishes the frame recorded in a query set. Results the GPU has not produced yet are reported
+// as -1 instead of waited for.
+static void CollectFrame(int set)
+{
+    PendingFrame &pending = g_pendingFrames[set];
+    if (!pending.active)
+        return;
+    pending.active = false;
+    for (int stage = 0; stage < kOceanStageCount; ++stage)
+    {
+        if (!pending.issued[stage])
+            continue;
+        const GLuint *queries = &g_stageQueries[set][2 * stage];
+        GLint available[2] = {0, 0};
+        glGetQueryObjectiv(queries[0], GL_QUERY_RESULT_AVAILABLE, &available[0]);
+        glGetQueryObjectiv(queries[1], GL_QUERY_RESULT_AVAILABLE, &available[1]);
+        if (!available[0] || !available[1])
+        {
+            pending.stats.gpuMs[stage] = -1.0f;
+            continue;
+        }
+        GLuint64 begin = 0, end = 0;
+        glGetQueryObjectui64v(queries[0], GL_QUERY_RESULT, &begin);
+        glGetQueryObjectui64v(queries[1], GL_QUERY_RESULT, &end);
+        pending.stats.gpuMs[stage] = static_cast<float>((end - begin) * 1e-6);
+    }
+    PublishFrame(pending.stats);
+}
 
-    // Extract real and upload to textures
-    ExtractToTexture(ssboTimeA, texA);
-    ExtractToTexture(ssboTimeB, texB);
+// Writer thread: every kStatsCSVPollMs writes the frames published after nextFrame once at least
+// interval of them are waiting (the rest when stopping). Frames the ring dropped are skipped.
+static void StatsCSVWriterMain(FILE *file, int interval, uint64_t nextFrame)
+{
+    static OceanStats stats; // too large for the stack, one writer at a time
+    for (;;)
+    {
+        const bool quit = g_statsCSVQuit.load(std::memory_order_acquire);
+        Ocean_GetStats(stats);
+        int first = 0;
+        while (first < stats.count && stats.frames[first].frame < nextFrame)
+            ++first;
+        if (stats.count - first >= interval || (quit && first < stats.count))
+        {
+            for (int i = first; i < stats.count; ++i)
+            {
+                const OceanFrameStats &frame = stats.frames[i];
+                fprintf(file, "%llu,%.4f", (unsigned long long)frame.frame, frame.cpuFrameMs);
+                for (int stage = 0; stage < kOceanStageCount; ++stage)
+                    fprintf(file, ",%.4f,%.4f", frame.gpuMs[stage], frame.cpuMs[stage]);
+                fprintf(file, ",%u,%u\n", frame.dispatches, frame.barriers);
+            }
+            fflush(file);
+            nextFrame = stats.frames[stats.count - 1].frame + 1;
+        }
+        if (quit)
+            return;
+        std::this_thread::sleep_for(std::chrono::milliseconds(kStatsCSVPollMs));
+    }
+}
 
-    // Cleanup
-    if (ssboTimeA)
-        glDeleteBuffers(1, &ssboTimeA);
-    if (ssboTimeB)
-        glDeleteBuffers(1, &ssboTimeB);
-    glDeleteBuffers(1, &ssboSpecA);
-    glDeleteBuffers(1, &ssboSpecB);
+static void BeginStage(OceanStage stage)
+{
+    if (!g_frame)
+        return;
+    glQueryCounter(g_stageQueries[g_frame - g_pendingFrames][2 * stage], GL_TIMESTAMP);
+    g_stageStart = std::chrono::steady_clock::now();
 }
 
-void SaveTextureToTGA(const char *filename, GLuint TextureID, int width, int height)
+static void EndStage(OceanStage stage)
 {
-    if (width <= 0 || height <= 0 || TextureID == 0)
+    if (!g_frame)
         return;
+    using namespace std::chrono;
+    g_frame->stats.cpuMs[stage] += duration<float, std::milli>(steady_clock::now() - g_stageStart).count();
+    glQueryCounter(g_stageQueries[g_frame - g_pendingFrames][2 * stage + 1], GL_TIMESTAMP);
+    g_frame->issued[stage] = true;
+}
 
-    // Read back floats from the R32F texture
-    std::vector<float> floats(static_cast<size_t>(width) * height);
-    glBindTexture(GL_TEXTURE_2D, TextureID);
-    glPixelStorei(GL_PACK_ALIGNMENT, 1);
-    glGetTexImage(GL_TEXTURE_2D, 0, GL_RED, GL_FLOAT, floats.data());
+// Dispatches and barriers issued by this file; the FFT keeps its own counters
+static void CountWork(unsigned dispatches, unsigned barriers)
+{
+    if (!g_frame)
+        return;
+    g_frame->stats.dispatches += dispatches;
+    g_frame->stats.barriers += barriers;
+}
+
+static void FFTPassHook(FFTAxisGPU axis, bool begin)
+{
+    OceanStage stage = axis == kFFTAxisColumns ? kOceanStageFFTColumns : kOceanStageFFTRows;
+    if (begin)
+        BeginStage(stage);
+    else
+        EndStage(stage);
+}
+
+// Publishes the frame previously recorded in this update's query set and starts a new record
+static void BeginFrameStats()
+{
+    if (!g_stageTiming)
+        return;
+    if (!g_stageQueries[0][0])
+        glGenQueries(kOceanStatsLatency * 2 * kOceanStageCount, &g_stageQueries[0][0]);
+
+    const int set = static_cast<int>(g_frameNumber % kOceanStatsLatency);
+    CollectFrame(set);
+    g_frame = &g_pendingFrames[set];
+    g_frame->stats = OceanFrameStats{};
+    g_frame->stats.frame = g_frameNumber;
+    std::fill(g_frame->issued, g_frame->issued + kOceanStageCount, false);
+    getFFTCountersGPU(&g_fftDispatches, &g_fftBarriers);
+    setFFTPassHookGPU(FFTPassHook);
+}
+
+static void EndFrameStats(std::chrono::steady_clock::time_point start)
+{
+    if (!g_frame)
+        return;
+    using namespace std::chrono;
+    unsigned dispatches, barriers;
+    getFFTCountersGPU(&dispatches, &barriers);
+    setFFTPassHookGPU(nullptr);
+    g_frame->stats.dispatches += dispatches - g_fftDispatches;
+    g_frame->stats.barriers += barriers - g_fftBarriers;
+    g_frame->stats.cpuFrameMs = duration<float, std::milli>(steady_clock::now() - start).count();
+    g_frame->active = true;
+    g_lastSet = static_cast<int>(g_frame - g_pendingFrames);
+    g_frame = nullptr;
+    ++g_frameNumber;
+}
+
+// Forgets recorded frames whose queries are about to be deleted or reissued
+static void DropPendingFrames()
+{
+    for (PendingFrame &pending : g_pendingFrames)
+        pending.active = false;
+    g_lastSet = -1;
+}
+
+void Ocean_SetStageTiming(bool enabled)
+{
+    if (!enabled)
+        DropPendingFrames();
+    g_stageTiming = enabled;
+}
+
+bool Ocean_GetStageTimes(double *ms)
+{
+    if (!ms || g_lastSet < 0)
+        return false;
+    const PendingFrame &pending = g_pendingFrames[g_lastSet];
+    for (int stage = 0; stage < kOceanStageCount; ++stage)
+    {
+        GLuint64 begin = 0, end = 0;
+        if (pending.issued[stage])
+        {
+            // Waits for the GPU
+            glGetQueryObjectui64v(g_stageQueries[g_lastSet][2 * stage], GL_QUERY_RESULT, &begin);
+            glGetQueryObjectui64v(g_stageQueries[g_lastSet][2 * stage + 1], GL_QUERY_RESULT, &end);
+        }
+        ms[stage] = (end - begin) * 1e-6;
+    }
+    return true;
+}
+
+void Ocean_GetStats(OceanStats &stats)
+{
+    const uint64_t published = g_statsPublished.load(std::memory_order_acquire);
+    const uint64_t first = published > kOceanStatsFrames ? published - kOceanStatsFrames : 0;
+    stats.count = 0;
+    for (uint64_t index = first; index < published; ++index)
+    {
+        const StatsSlot &slot = g_statsRing[index % kOceanStatsFrames];
+        const uint64_t seq = slot.seq.load(std::memory_order_acquire);
+        if (seq != 2 * index + 2)
+            continue; // already overwritten by a newer frame
+        OceanFrameStats copy = slot.stats;
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot.seq.load(std::memory_order_relaxed) != seq)
+            continue;
+        stats.frames[stats.count++] = copy;
+    }
+}
+
+bool Ocean_SetStatsCSV(const char *path, int intervalFrames)
+{
+    if (g_statsCSVWriter.joinable())
+    {
+        g_statsCSVQuit.store(true, std::memory_order_release);
+        g_statsCSVWriter.join();
+        g_statsCSVQuit.store(false, std::memory_order_relaxed);
+    }
+    if (g_statsCSV)
+        fclose(g_statsCSV);
+    g_statsCSV = nullptr;
+    if (!path)
+        return true;
+
+    g_statsCSV = fopen(path, "w");
+    if (!g_statsCSV)
+    {
+        printf("Could not open %s for the ocean statistics.\n", path);
+        return false;
+    }
+    fprintf(g_statsCSV, "frame,cpu_frame_ms");
+    static const char *kStageNames[kOceanStageCount] = {"evolve", "fft_columns", "fft_rows", "outputs"};
+    for (const char *name : kStageNames)
+        fprintf(g_statsCSV, ",%s_gpu_ms,%s_cpu_ms", name, name);
+    fprintf(g_statsCSV, ",dispatches,barriers\n");
+
+    // Start after the newest frame already published
+    static OceanStats stats;
+    Ocean_GetStats(stats);
+    uint64_t nextFrame = stats.count ? stats.frames[stats.count - 1].frame + 1 : 0;
+    // Batches must be written before the ring wraps past them
+    int interval = std::min(std::max(intervalFrames, 1), kOceanStatsFrames / 2);
+    g_statsCSVWriter = std::thread(StatsCSVWriterMain, g_statsCSV, interval, nextFrame);
+    return true;
+}
+
+// Per-cascade output scale relative to the primary patch. The generator leaves out the spectral
+// bin area dk^2, so a cascade's amplitudes are L0 / L larger; slopes are per texel, so bringing
+// them to primary-patch texels adds another L0 / L.
+static void CascadeScales(int derivativeOrder, float *scales)
+{
+    for (int c = 0; c < g_cascadeCount; ++c)
+    {
+        float ratio = g_cascadeSizes[0] / g_cascadeSizes[c];
+        scales[c] = derivativeOrder ? ratio * ratio : ratio;
+    }
+}
+
+// Normalizes the real time-domain fields of the C2R output, computes the jacobian and writes every
+// output texture (and the normal map) in one dispatch for all cascades.
+static void BuildOutputTextures(GLuint timeSSBO)
+{
+    if (!outputsProgram || !timeSSBO)
+        return;
+
+    float fieldScales[kOceanMaxCascades], slopeScales[kOceanMaxCascades];
+    CascadeScales(0, fieldScales);
+    CascadeScales(1, slopeScales);
+    float scales[kOceanMaxCascades][2];
+    float cellSizes[kOceanMaxCascades];
+    for (int c = 0; c < g_cascadeCount; ++c)
+    {
+        scales[c][0] = fieldScales[c];
+        scales[c][1] = slopeScales[c];
+        cellSizes[c] = g_cascadeSizes[c] / static_cast<float>(g_resolution);
+    }
+
+    glUseProgram(outputsProgram);
+    glUniform1i(glGetUniformLocation(outputsProgram, "u_N"), g_resolution);
+    glUniform1i(glGetUniformLocation(outputsProgram, "u_CascadeStride"), kSpecCount * g_resolution * g_resolution);
+    glUniform2fv(glGetUniformLocation(outputsProgram, "u_Scales"), g_cascadeCount, &scales[0][0]);
+    glUniform1fv(glGetUniformLocation(outputsProgram, "u_CellSizes"), g_cascadeCount, cellSizes);
+    glUniform1f(glGetUniformLocation(outputsProgram, "u_Amplitude"), g_amplitudeScale);
+    glUniform1f(glGetUniformLocation(outputsProgram, "u_Choppiness"), g_choppiness);
+    glUniform1i(glGetUniformLocation(outputsProgram, "u_half"), g_halfPrecision ? 1 : 0);
+    glUniform1i(glGetUniformLocation(outputsProgram, "u_Packed"), g_packedOutput ? 1 : 0);
+    glUniform1i(glGetUniformLocation(outputsProgram, "u_WriteNormals"), normalTex ? 1 : 0);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, timeSSBO);
+
+    // Image units as laid out in ocean_outputs.comp
+    const GLuint separate[] = {heightTex, slopeXTex, slopeZTex, dispXTex, dispZTex, jacobianTex};
+    const GLuint packed[] = {displacementTex, slopeTex};
+    const GLuint *units = g_packedOutput ? packed : separate;
+    const int unitCount = g_packedOutput ? 2 : 6;
+    for (int unit = 0; unit < unitCount; ++unit)
+        glBindImageTexture(unit, units[unit], 0, GL_TRUE, 0, GL_WRITE_ONLY, OutputFormat());
+    if (normalTex)
+        glBindImageTexture(6, normalTex, 0, GL_TRUE, 0, GL_WRITE_ONLY, GL_RGBA8_SNORM);
+
+    int groups = (g_resolution + 15) / 16; // 16 x 16 tiles
+    glDispatchCompute(groups, groups, g_cascadeCount);
+}
+
+// Saves one layer (cascade) of a texture array, normalized to that layer's range
+void SaveTextureToTGA(const char *filename, GLuint TextureID, int width, int height, int layer = 0)
+{
+    if (width <= 0 || height <= 0 || TextureID == 0 || layer < 0 || layer >= g_cascadeCount)
+        return;
+
+    // Read back floats from the texture array (all layers come back together)
+    std::vector<float> layers(static_cast<size_t>(width) * height * g_cascadeCount);
+    ReadTextureLayers(TextureID, 0, layers.data());
+    const float *floats = layers.data() + static_cast<size_t>(layer) * width * height;
 
     // Find range for normalization (you can clamp to a known range if preferred)
     float vmin = +std::numeric_limits<float>::infinity();
     float vmax = -std::numeric_limits<float>::infinity();
-    for (float v : floats)
+    for (int i = 0; i < width * height; ++i)
     {
+        float v = floats[i];
         vmin = std::min(vmin, v);
         vmax = std::max(vmax, v);
     }
@@ -175,7 +602,28 @@ void SaveTextureToTGA(const char *filename, GLuint TextureID, int width, int hei
     delete[] texData.imageData;
 }
 
-void Ocean_Init(OceanInitParams params)
+// Same fallbacks for Ocean_Init and Ocean_SetParams
+static OceanInitParams SanitizeParams(OceanInitParams params)
+{
+    if (params.domainSize <= 0.0f)
+        params.domainSize = 1.0f;
+    if (params.gravity <= 0.0f)
+        params.gravity = 9.81f;
+    if (params.amplitudeScale <= 0.0f)
+        params.amplitudeScale = 1.0f;
+    if (params.choppiness < 0.0f)
+        params.choppiness = 0.0f;
+    params.cascadeCount = std::min(std::max(params.cascadeCount, 1), kOceanMaxCascades);
+    for (OceanCascadeParams &cascade : params.detailCascades)
+    {
+        if (cascade.domainSize <= 0.0f)
+            cascade.domainSize = 1.0f;
+    }
+    return params;
+}
+
+// Mirror g_oceanParams into the cached values passed to the shaders
+static void ApplyParams(const OceanInitParams &params)
 {
     g_oceanParams = params;
     g_resolution = params.resolution;
@@ -183,45 +631,280 @@ void Ocean_Init(OceanInitParams params)
     g_gravity = params.gravity;
     g_amplitudeScale = params.amplitudeScale;
     g_choppiness = params.choppiness;
+    g_cascadeCount = params.cascadeCount;
+    g_halfPrecision = params.precision == kOceanPrecisionHalf;
+    g_packedOutput = params.outputLayout == kOceanOutputPacked;
+    for (int c = 0; c < g_cascadeCount; ++c)
+        g_cascadeSizes[c] = c == 0 ? params.domainSize : params.detailCascades[c - 1].domainSize;
+}
 
-    if (g_patchSize <= 0.0f)
-        g_patchSize = 1.0f;
-    if (g_gravity <= 0.0f)
-        g_gravity = 9.81f;
-    if (g_amplitudeScale <= 0.0f)
-        g_amplitudeScale = 1.0f;
-    if (g_choppiness < 0.0f)
-        g_choppiness = 0.0f;
+static void LoadPrograms()
+{
+    if (evolveProgram)
+        return; // programs do not depend on parameters, compile them once
 
-    g_oceanParams.domainSize = g_patchSize;
-    g_oceanParams.gravity = g_gravity;
-    g_oceanParams.amplitudeScale = g_amplitudeScale;
-    g_oceanParams.choppiness = g_choppiness;
+    evolveProgram = loadComputeShader("shaders/ocean_evolve.comp");
+    outputsProgram = loadComputeShader("shaders/ocean_outputs.comp");
+    if (!evolveProgram || !outputsProgram)
+        std::cout << "Failed to load ocean compute shaders (evolve/outputs)\n";
+}
 
-    // Initialize SSBO-based ocean data and compute pipeline (H0/Ht/height buffer)
-    ocean_init(g_oceanParams);
+// Everything sized by the resolution and cascade count: FFT plan, spectra and output textures
+static void CreateResolutionResources()
+{
+    // FFT scratch and the spectra are reused every frame
+    g_fftPlan = createFFTPlanGPU(g_resolution, g_resolution, kSpecCount * g_cascadeCount, true, g_halfPrecision);
+    glGenBuffers(1, &ssboSpectra);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, ssboSpectra);
+    const size_t specBytes = g_halfPrecision ? sizeof(GLuint) : sizeof(Complex);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, specBytes * HalfSpectrumSize() * kSpecCount * g_cascadeCount,
+                 nullptr, GL_DYNAMIC_COPY);
+    glGenBuffers(1, &ssboDispersion);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, ssboDispersion);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(float) * HalfSpectrumSize() * g_cascadeCount, nullptr, GL_STATIC_DRAW);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+    UploadDispersionTable();
 
-    evolveProgram = loadComputeShader("shaders/ocean_evolve.comp");
-    extractProgram = loadComputeShader("shaders/ocean_extract_height.comp");
-    slopeSpecProgram = loadComputeShader("shaders/ocean_slope_spectrum.comp");
-    displacementSpecProgram = loadComputeShader("shaders/ocean_displacement_spectrum.comp");
-    jacobianProgram = loadComputeShader("shaders/ocean_jacobian.comp");
-    if (!evolveProgram || !extractProgram || !slopeSpecProgram || !displacementSpecProgram || !jacobianProgram)
-        std::cout << "Failed to load ocean compute shaders (evolve/extract/slope/displacement/jacobian)\n";
+    if (g_oceanParams.normalMap)
+        Texture_Init(normalTex, g_resolution, g_resolution, g_cascadeCount, GL_RGBA8_SNORM);
+
+    if (g_packedOutput)
+    {
+        // (dispX, height, dispZ) for water.vert, (slopeX, slopeZ, jacobian) for water.frag
+        Texture_Init(displacementTex, g_resolution, g_resolution, g_cascadeCount, OutputFormat());
+        Texture_Init(slopeTex, g_resolution, g_resolution, g_cascadeCount, OutputFormat());
+        return;
+    }
 
     // Create the height texture used by the vertex shader
-    Texture_Init(heightTex, g_resolution, g_resolution);
+    Texture_Init(heightTex, g_resolution, g_resolution, g_cascadeCount, OutputFormat());
 
     // Create slope textures
-    Texture_Init(slopeXTex, g_resolution, g_resolution);
-    Texture_Init(slopeZTex, g_resolution, g_resolution);
+    Texture_Init(slopeXTex, g_resolution, g_resolution, g_cascadeCount, OutputFormat());
+    Texture_Init(slopeZTex, g_resolution, g_resolution, g_cascadeCount, OutputFormat());
 
     // Create displacement textures (horizontal choppy displacements)
-    Texture_Init(dispXTex, g_resolution, g_resolution);
-    Texture_Init(dispZTex, g_resolution, g_resolution);
+    Texture_Init(dispXTex, g_resolution, g_resolution, g_cascadeCount, OutputFormat());
+    Texture_Init(dispZTex, g_resolution, g_resolution, g_cascadeCount, OutputFormat());
 
     // Create jacobian texture
-    Texture_Init(jacobianTex, g_resolution, g_resolution);
+    Texture_Init(jacobianTex, g_resolution, g_resolution, g_cascadeCount, OutputFormat());
+}
+
+static void ReleaseResolutionResources()
+{
+    destroyFFTPlanGPU(g_fftPlan);
+    g_fftPlan = nullptr;
+    if (ssboSpectra)
+        glDeleteBuffers(1, &ssboSpectra);
+    ssboSpectra = 0;
+    GLuint buffers[] = {ssboDispersion, ssboPhase};
+    glDeleteBuffers(2, buffers); // zero names are ignored
+    ssboDispersion = ssboPhase = 0;
+    g_phaseSteps = -1;
+
+    GLuint textures[] = {heightTex, slopeXTex, slopeZTex, dispXTex, dispZTex, jacobianTex,
+                         displacementTex, slopeTex, normalTex};
+    glDeleteTextures(9, textures); // zero names are ignored
+    heightTex = slopeXTex = slopeZTex = dispXTex = dispZTex = jacobianTex = 0;
+    displacementTex = slopeTex = normalTex = 0;
+}
+
+void Ocean_Init(OceanInitParams params)
+{
+    // Re-initializing replaces the previous resources instead of leaking them
+    ReleaseResolutionResources();
+    ocean_release();
+
+    ApplyParams(SanitizeParams(params));
+
+    // Initialize SSBO-based ocean data and compute pipeline (H0/Ht/height buffer)
+    ocean_init(g_oceanParams);
+
+    LoadPrograms();
+    CreateResolutionResources();
+}
+
+void Ocean_Shutdown()
+{
+    ReleaseResolutionResources();
+    ocean_release();
+
+    DropPendingFrames();
+    if (g_stageQueries[0][0])
+        glDeleteQueries(kOceanStatsLatency * 2 * kOceanStageCount, &g_stageQueries[0][0]);
+    std::fill(&g_stageQueries[0][0], &g_stageQueries[0][0] + kOceanStatsLatency * 2 * kOceanStageCount, 0u);
+    Ocean_SetStatsCSV(nullptr);
+
+    GLuint *programs[] = {&evolveProgram, &outputsProgram};
+    for (GLuint *program : programs)
+    {
+        if (*program)
+            glDeleteProgram(*program);
+        *program = 0;
+    }
+    g_resolution = 0;
+}
+
+unsigned Ocean_ClassifyParamChange(const OceanInitParams &from, const OceanInitParams &to)
+{
+    unsigned changes = kOceanChangeNone;
+    if (from.time_scale != to.time_scale || from.amplitudeScale != to.amplitudeScale ||
+        from.choppiness != to.choppiness)
+        changes |= kOceanChangeUniforms;
+    if (from.windDirection.x != to.windDirection.x || from.windDirection.y != to.windDirection.y ||
+        from.windSpeed != to.windSpeed || from.alpha != to.alpha || from.gamma != to.gamma ||
+        from.spreadExponent != to.spreadExponent || from.lowCutoff != to.lowCutoff ||
+        from.highCutoff != to.highCutoff || from.randomSeed != to.randomSeed ||
+        from.domainSize != to.domainSize || from.gravity != to.gravity)
+        changes |= kOceanChangeSpectrum;
+    for (int c = 0; c < kOceanMaxCascades - 1; ++c)
+    {
+        const OceanCascadeParams &a = from.detailCascades[c];
+        const OceanCascadeParams &b = to.detailCascades[c];
+        if (a.domainSize != b.domainSize || a.lowCutoff != b.lowCutoff || a.highCutoff != b.highCutoff)
+            changes |= kOceanChangeSpectrum;
+    }
+    if (from.resolution != to.resolution || from.cascadeCount != to.cascadeCount || from.precision != to.precision ||
+        from.outputLayout != to.outputLayout || from.normalMap != to.normalMap)
+        changes |= kOceanChangeResolution;
+    return changes;
+}
+
+unsigned Ocean_SetParams(const OceanInitParams &userParams)
+{
+    OceanInitParams params = SanitizeParams(userParams);
+    unsigned changes = Ocean_ClassifyParamChange(g_oceanParams, params);
+    if (changes == kOceanChangeNone)
+        return changes;
+
+    if (changes & kOceanChangeResolution)
+    {
+        // Buffers and textures are sized by N; the compiled programs are kept
+        Ocean_Init(params);
+        return changes;
+    }
+
+    // omega(k) depends only on N, gravity and the cascade sizes: wind, spectrum shape, cutoff and seed
+    // changes keep the table and the stored phases
+    bool dispersionChanged = params.gravity != g_gravity;
+    for (int c = 0; c < g_cascadeCount; ++c)
+    {
+        float size = c == 0 ? params.domainSize : params.detailCascades[c - 1].domainSize;
+        dispersionChanged |= size != g_cascadeSizes[c];
+    }
+
+    ApplyParams(params);
+    if (changes & kOceanChangeSpectrum)
+    {
+        ocean_generate_h0(g_oceanParams); // in place, one dispatch
+        if (dispersionChanged)
+            UploadDispersionTable();
+    }
+    return changes;
+}
+
+static void ApplyParamDelta(OceanInitParams &params, const OceanParamDelta &delta);
+
+// Spill for a full queue, shared with the consumer as a seqlock: g_spillSeq is odd while the
+// producer rewrites g_spillSlot. The consumer stores the sequence it applied in g_spillTaken.
+// Until then every push folds into the spill, so queued deltas are always older than it.
+static std::atomic<uint32_t> g_spillSeq{0};
+static std::atomic<uint32_t> g_spillTaken{0};
+static OceanParamDelta g_spillSlot = {0, OceanInitParams()};
+
+void Ocean_PushParamDelta(const OceanParamDelta &delta)
+{
+    const uint32_t seq = g_spillSeq.load(std::memory_order_relaxed);
+    const bool spillPending = seq != g_spillTaken.load(std::memory_order_acquire);
+    if (!spillPending && SPSCQueue_Push(g_paramQueue, delta))
+        return;
+
+    // Only this thread writes the slot, so reading it here needs no synchronization
+    OceanParamDelta spill = spillPending ? g_spillSlot : OceanParamDelta{0, OceanInitParams()};
+    ApplyParamDelta(spill.values, delta);
+    spill.fields |= delta.fields;
+
+    g_spillSeq.store(seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    g_spillSlot = spill;
+    g_spillSeq.store(seq + 2, std::memory_order_release);
+}
+
+static void ApplyParamDelta(OceanInitParams &params, const OceanParamDelta &delta)
+{
+    const OceanInitParams &v = delta.values;
+    if (delta.fields & kOceanParamTimeScale)
+        params.time_scale = v.time_scale;
+    if (delta.fields & kOceanParamResolution)
+        params.resolution = v.resolution;
+    if (delta.fields & kOceanParamDomainSize)
+        params.domainSize = v.domainSize;
+    if (delta.fields & kOceanParamWindDirection)
+        params.windDirection = v.windDirection;
+    if (delta.fields & kOceanParamWindSpeed)
+        params.windSpeed = v.windSpeed;
+    if (delta.fields & kOceanParamAlpha)
+        params.alpha = v.alpha;
+    if (delta.fields & kOceanParamGamma)
+        params.gamma = v.gamma;
+    if (delta.fields & kOceanParamSpreadExponent)
+        params.spreadExponent = v.spreadExponent;
+    if (delta.fields & kOceanParamLowCutoff)
+        params.lowCutoff = v.lowCutoff;
+    if (delta.fields & kOceanParamHighCutoff)
+        params.highCutoff = v.highCutoff;
+    if (delta.fields & kOceanParamGravity)
+        params.gravity = v.gravity;
+    if (delta.fields & kOceanParamAmplitudeScale)
+        params.amplitudeScale = v.amplitudeScale;
+    if (delta.fields & kOceanParamChoppiness)
+        params.choppiness = v.choppiness;
+    if (delta.fields & kOceanParamRandomSeed)
+        params.randomSeed = v.randomSeed;
+    if (delta.fields & kOceanParamCascades)
+    {
+        params.cascadeCount = v.cascadeCount;
+        for (int c = 0; c < kOceanMaxCascades - 1; ++c)
+            params.detailCascades[c] = v.detailCascades[c];
+    }
+    if (delta.fields & kOceanParamPrecision)
+        params.precision = v.precision;
+    if (delta.fields & kOceanParamOutputLayout)
+        params.outputLayout = v.outputLayout;
+    if (delta.fields & kOceanParamNormalMap)
+        params.normalMap = v.normalMap;
+}
+
+// Coalesces everything queued since the last frame into one Ocean_SetParams: later deltas
+// override earlier ones field by field, and values equal to the current ones cost nothing.
+// A spill is read before the queue is drained and applied after it: while a spill is pending the
+// producer only pushes into the spill, so everything in the queue is older.
+static void DrainParamQueue()
+{
+    OceanParamDelta spill;
+    const uint32_t seq = g_spillSeq.load(std::memory_order_acquire);
+    bool hasSpill = false;
+    if ((seq & 1u) == 0 && seq != g_spillTaken.load(std::memory_order_relaxed))
+    {
+        spill = g_spillSlot;
+        std::atomic_thread_fence(std::memory_order_acquire);
+        hasSpill = g_spillSeq.load(std::memory_order_relaxed) == seq; // else retried next frame
+    }
+
+    OceanParamDelta delta;
+    bool hasDelta = SPSCQueue_Pop(g_paramQueue, delta);
+    if (!hasDelta && !hasSpill)
+        return;
+
+    OceanInitParams pending = g_oceanParams;
+    for (; hasDelta; hasDelta = SPSCQueue_Pop(g_paramQueue, delta))
+        ApplyParamDelta(pending, delta);
+    if (hasSpill)
+        ApplyParamDelta(pending, spill);
+    Ocean_SetParams(pending);
+    if (hasSpill)
+        g_spillTaken.store(seq, std::memory_order_release);
 }
 
 float GetTimeSeconds()
@@ -234,79 +917,82 @@ float GetTimeSeconds()
 
 void Ocean_Update()
 {
-    // 1) Evolve spectrum H(k,t) from H0(k)
-    if (evolveProgram && ssboH0 && ssboHt && g_resolution > 0)
+    Ocean_UpdateAtTime(GetTimeSeconds());
+}
+
+void Ocean_UpdateAtTime(float seconds)
+{
+    const auto frameStart = std::chrono::steady_clock::now();
+    DrainParamQueue();
+    BeginFrameStats();
+
+    // 1) Evolve spectrum H(k,t) from H0(k) and build the slope spectra Sx/Sz and horizontal
+    //    displacement spectra Dx/Dz from it in the same pass
+    if (evolveProgram && ssboH0 && ssboSpectra && ssboDispersion && g_resolution > 0)
     {
+        float t = seconds * g_oceanParams.time_scale;
+        float dt = g_fixedTimestep * g_oceanParams.time_scale;
+
+        // Phase mode: 0 exact, 1 exact and store it, 2 rotate the stored phase (see ocean_evolve.comp).
+        // Rotating is only valid when this update is exactly one step after the stored phase.
+        int phaseMode = 0;
+        if (dt > 0.0f)
+        {
+            if (!ssboPhase)
+            {
+                glGenBuffers(1, &ssboPhase);
+                glBindBuffer(GL_SHADER_STORAGE_BUFFER, ssboPhase);
+                glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(float) * 4 * HalfSpectrumSize() * g_cascadeCount,
+                             nullptr, GL_DYNAMIC_COPY);
+                glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+            }
+            bool nextStep = g_phaseSteps >= 0 && g_phaseSteps < kPhaseResyncInterval && dt == g_phaseStep &&
+                            std::fabs(t - (g_phaseTime + dt)) <= 1e-3f * dt;
+            phaseMode = nextStep ? 2 : 1;
+            g_phaseSteps = nextStep ? g_phaseSteps + 1 : 0;
+            g_phaseTime = t;
+            g_phaseStep = dt;
+        }
+
         glUseProgram(evolveProgram);
         glUniform1i(glGetUniformLocation(evolveProgram, "u_N"), g_resolution);
-        glUniform1f(glGetUniformLocation(evolveProgram, "u_domainSize"), g_patchSize);
-        glUniform1f(glGetUniformLocation(evolveProgram, "u_gravity"), g_gravity);
-
-        float t = GetTimeSeconds() * g_oceanParams.time_scale;
+        glUniform1i(glGetUniformLocation(evolveProgram, "u_CascadeStride"), kSpecCount * HalfSpectrumSize());
+        glUniform1i(glGetUniformLocation(evolveProgram, "u_SpecStride"), HalfSpectrumSize());
         glUniform1f(glGetUniformLocation(evolveProgram, "u_time"), t);
+        glUniform1f(glGetUniformLocation(evolveProgram, "u_dt"), dt);
+        glUniform1i(glGetUniformLocation(evolveProgram, "u_phaseMode"), phaseMode);
+        glUniform1i(glGetUniformLocation(evolveProgram, "u_half"), g_halfPrecision ? 1 : 0);
 
         glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, ssboH0);
-        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, ssboHt);
-        int total = g_resolution * g_resolution;
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, ssboSpectra);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, ssboDispersion);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, ssboPhase);
+        int total = HalfSpectrumSize();
         int groups = (total + 256 - 1) / 256; // local_size_x = 256
-        glDispatchCompute(groups, 1, 1);
+        BeginStage(kOceanStageEvolve);
+        glDispatchCompute(groups, g_cascadeCount, 1);
         glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+        CountWork(1, 1);
+        EndStage(kOceanStageEvolve);
     }
 
-    // 2) Inverse 2D FFT to time-domain heights (complex)
+    // 2) One batched complex-to-real inverse 2D FFT for all spectra (real, time domain)
     GLuint timeSSBO = 0;
-    if (ssboHt && g_resolution > 0)
+    if (ssboSpectra && g_fftPlan && g_resolution > 0)
     {
-        timeSSBO = computeIFFT2D(ssboHt, g_resolution, g_resolution);
+        timeSSBO = executeIFFT2DC2RBatchGPU(g_fftPlan, ssboSpectra, kSpecCount * g_cascadeCount);
     }
 
-    // 3) Extract real height and upload to texture directly on the GPU
-    if (timeSSBO && extractProgram)
+    // 3) Normalize the real fields, compute the jacobian and write every output texture in one pass
+    if (timeSSBO && outputsProgram)
     {
-        ExtractToTexture(timeSSBO, heightTex);
+        BeginStage(kOceanStageOutputs);
+        BuildOutputTextures(timeSSBO);
+        glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT | GL_TEXTURE_FETCH_BARRIER_BIT);
+        CountWork(1, 1);
+        EndStage(kOceanStageOutputs);
         // SaveTextureToTGA("./out/ocean_height.tga", heightTex, g_resolution, g_resolution);
     }
-    if (timeSSBO)
-    {
-        glDeleteBuffers(1, &timeSSBO);
-    }
-
-    // 4) Build slope fields Sx/Sz and upload
-    if (ssboHt && g_resolution > 0)
-    {
-        BuildFieldsFromHt(slopeSpecProgram, ssboHt, slopeXTex, slopeZTex);
-    }
-
-    // 5) Build horizontal displacement fields Dx/Dz and upload
-    if (ssboHt && g_resolution > 0)
-    {
-        BuildFieldsFromHt(displacementSpecProgram, ssboHt, dispXTex, dispZTex);
-    }
-
-    // 6) Compute jacobian determinant texture from displaced field
-    if (jacobianProgram && g_resolution > 0)
-    {
-        glUseProgram(jacobianProgram);
-        float cellSize = g_patchSize / static_cast<float>(g_resolution);
-        glUniform1f(glGetUniformLocation(jacobianProgram, "u_CellSize"), cellSize);
-        glUniform1f(glGetUniformLocation(jacobianProgram, "u_Amplitude"), g_amplitudeScale);
-        glUniform1f(glGetUniformLocation(jacobianProgram, "u_Choppiness"), g_choppiness);
-        glUniform1i(glGetUniformLocation(jacobianProgram, "u_DispX"), 0);
-        glUniform1i(glGetUniformLocation(jacobianProgram, "u_DispZ"), 1);
-
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, dispXTex);
-        glActiveTexture(GL_TEXTURE1);
-        glBindTexture(GL_TEXTURE_2D, dispZTex);
-
-        glBindImageTexture(0, jacobianTex, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_R32F);
-
-        int groups = (g_resolution + 15) / 16;
-        glDispatchCompute(groups, groups, 1);
-        glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT | GL_TEXTURE_FETCH_BARRIER_BIT);
-
-        // SaveTextureToTGA("./out/ocean_jacobian.tga", jacobianTex, g_resolution, g_resolution);
 
-        glActiveTexture(GL_TEXTURE0);
-    }
+    EndFrameStats(frameStart);
 }
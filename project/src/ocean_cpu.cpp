@@ -0,0 +1,263 @@
+#include "ocean_cpu.h"
+
+#include <cmath>
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+
+#include "fft_cpu.h"
+#include "ocean_spectrum.h"
+#include "ocean_spectrum_cache.h"
+#include "thread_pool.h"
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+// Half spectra (N x (N/2 + 1) bins) transformed each frame, in the order they are stored back to
+// back. Same order as the first OceanField entries, so the C2R output lands in fields directly.
+enum
+{
+    kSpecHeight, // H(k, t)
+    kSpecSlopeX,
+    kSpecSlopeZ,
+    kSpecDispX,
+    kSpecDispZ,
+    kSpecCount
+};
+
+struct OceanCPU
+{
+    OceanInitParams params;
+    int N = 0;
+    ThreadPool *pool = nullptr;
+    FFTPlanCPU *plan = nullptr;
+    std::vector<Complex> h0;      // (h0(k), h0(-k)) pairs per half-spectrum bin
+    std::vector<float> omega;     // sqrt(g |k|) per half-spectrum bin
+    std::vector<Complex> spectra; // kSpecCount half spectra
+    std::vector<float> fields;    // kOceanFieldCount * N * N
+};
+
+// Rows per parallel chunk for the per-texel passes.
+static const int kRowGrain = 4;
+
+// Mirrors the fused ocean_evolve.comp kernel: H(k,t) and the slope/displacement spectra
+// in a single pass over the half-spectrum H0 per row.
+static void buildSpectraRows(OceanCPU *ocean, float t, int v0, int v1)
+{
+    const int N = ocean->N;
+    const int bins = N / 2 + 1;
+    const size_t halfSize = static_cast<size_t>(N) * bins;
+    const float twoPiOverN = static_cast<float>(2.0 * M_PI) / static_cast<float>(N);
+    const Complex *H0 = ocean->h0.data();
+    const float *omegas = ocean->omega.data();
+    Complex *spec = ocean->spectra.data();
+
+    for (int v = v0; v < v1; ++v)
+    {
+        const int ky = v < N / 2 ? v : v - N;
+        for (int u = 0; u < bins; ++u)
+        {
+            const size_t id = static_cast<size_t>(v) * bins + u;
+            const int kxIndex = u < N / 2 ? u : u - N;
+
+            float c = std::cos(omegas[id] * t);
+            float s = std::sin(omegas[id] * t);
+
+            Complex h0k = H0[2 * id];
+            Complex h0mk = H0[2 * id + 1];
+
+            // h(k,t) = h0(k) e^{iwt} + conj(h0(-k)) e^{-iwt}
+            Complex H;
+            H.x = (h0k.x * c - h0k.y * s) + (h0mk.x * c - h0mk.y * s);
+            H.y = (h0k.x * s + h0k.y * c) - (h0mk.x * s + h0mk.y * c);
+            spec[kSpecHeight * halfSize + id] = H;
+
+            // Derivative spectra use the grid wave numbers, as in the compute shaders, with the
+            // self-mirrored Nyquist row/column dropped so each field stays Hermitian.
+            float gx = kxIndex * twoPiOverN;
+            float gy = ky * twoPiOverN;
+            float gLen = std::sqrt(gx * gx + gy * gy);
+            if (u == N / 2)
+                gx = 0.0f;
+            if (v == N / 2)
+                gy = 0.0f;
+            spec[kSpecSlopeX * halfSize + id] = {-gx * H.y, gx * H.x};
+            spec[kSpecSlopeZ * halfSize + id] = {-gy * H.y, gy * H.x};
+
+            if (gLen < 1e-6f)
+            {
+                spec[kSpecDispX * halfSize + id] = {0.0f, 0.0f};
+                spec[kSpecDispZ * halfSize + id] = {0.0f, 0.0f};
+            }
+            else
+            {
+                float nx = gx / gLen;
+                float ny = gy / gLen;
+                spec[kSpecDispX * halfSize + id] = {nx * H.y, -nx * H.x};
+                spec[kSpecDispZ * halfSize + id] = {ny * H.y, -ny * H.x};
+            }
+        }
+    }
+}
+
+// Mirrors ocean_outputs.comp: the spectra are in FFT order, so only 1/(N*N) remains.
+static void normalizeRows(OceanCPU *ocean, int y0, int y1)
+{
+    const int N = ocean->N;
+    const size_t fieldSize = static_cast<size_t>(N) * N;
+    const float norm = 1.0f / static_cast<float>(fieldSize);
+    for (int spec = 0; spec < kSpecCount; ++spec)
+    {
+        float *field = ocean->fields.data() + spec * fieldSize;
+        for (size_t id = static_cast<size_t>(y0) * N; id < static_cast<size_t>(y1) * N; ++id)
+            field[id] *= norm;
+    }
+}
+
+// Mirrors the jacobian of ocean_outputs.comp: central differences of the displacement with wrap-around.
+static void jacobianRows(OceanCPU *ocean, int y0, int y1)
+{
+    const int N = ocean->N;
+    const size_t fieldSize = static_cast<size_t>(N) * N;
+    const float *dispX = ocean->fields.data() + kOceanFieldDispX * fieldSize;
+    const float *dispZ = ocean->fields.data() + kOceanFieldDispZ * fieldSize;
+    float *jacobian = ocean->fields.data() + kOceanFieldJacobian * fieldSize;
+
+    const float cellSize = ocean->params.domainSize / static_cast<float>(N);
+    const float scale = -ocean->params.amplitudeScale * ocean->params.choppiness;
+    const float inv2Cell = (scale != 0.0f) ? (scale / (2.0f * cellSize)) : 0.0f;
+
+    for (int y = y0; y < y1; ++y)
+    {
+        const size_t rowP = static_cast<size_t>((y + 1) % N) * N;
+        const size_t rowM = static_cast<size_t>((y + N - 1) % N) * N;
+        const size_t row = static_cast<size_t>(y) * N;
+        for (int x = 0; x < N; ++x)
+        {
+            const int xP = (x + 1) % N;
+            const int xM = (x + N - 1) % N;
+
+            float dDx_dx = (dispX[row + xP] - dispX[row + xM]) * inv2Cell;
+            float dDx_dz = (dispX[rowP + x] - dispX[rowM + x]) * inv2Cell;
+            float dDz_dx = (dispZ[row + xP] - dispZ[row + xM]) * inv2Cell;
+            float dDz_dz = (dispZ[rowP + x] - dispZ[rowM + x]) * inv2Cell;
+
+            jacobian[row + x] = (1.0f + dDx_dx) * (1.0f + dDz_dz) - dDx_dz * dDz_dx;
+        }
+    }
+}
+
+OceanCPU *OceanCPU_Create(const OceanInitParams &params, ThreadPool *pool)
+{
+    OceanCPU *ocean = new OceanCPU();
+    ocean->params = params;
+    ocean->pool = pool;
+
+    // Same sanitization as Ocean_Init so both paths see identical parameters.
+    if (ocean->params.domainSize <= 0.0f)
+        ocean->params.domainSize = 1.0f;
+    if (ocean->params.gravity <= 0.0f)
+        ocean->params.gravity = 9.81f;
+    if (ocean->params.amplitudeScale <= 0.0f)
+        ocean->params.amplitudeScale = 1.0f;
+    if (ocean->params.choppiness < 0.0f)
+        ocean->params.choppiness = 0.0f;
+
+    ocean->N = ocean->params.resolution;
+    ocean->plan = createFFTPlanCPU(ocean->N, ocean->N);
+    if (!ocean->plan)
+    {
+        printf("OceanCPU_Create: unsupported resolution %d.\n", ocean->N);
+        delete ocean;
+        return nullptr;
+    }
+
+    const size_t fieldSize = static_cast<size_t>(ocean->N) * ocean->N;
+    const size_t halfSize = static_cast<size_t>(ocean->N) * (ocean->N / 2 + 1);
+    ocean->h0.resize(2 * halfSize);
+    if (OceanSpectrumCacheEntry *cached = OceanSpectrumCache_Open(ocean->params, kOceanSpectrumGeneratorCPU))
+    {
+        memcpy(ocean->h0.data(), OceanSpectrumCache_Pairs(cached), sizeof(Complex) * ocean->h0.size());
+        OceanSpectrumCache_Close(cached);
+    }
+    else
+    {
+        std::vector<Complex> fullH0(fieldSize);
+        Ocean_GenerateH0(ocean->params, fullH0.data(), ocean->pool);
+        Ocean_PackHalfSpectrumH0(ocean->N, fullH0.data(), ocean->h0.data());
+
+        Complex *pairs = nullptr;
+        if (OceanSpectrumCacheEntry *entry = OceanSpectrumCache_Create(ocean->params, kOceanSpectrumGeneratorCPU, &pairs))
+        {
+            memcpy(pairs, ocean->h0.data(), sizeof(Complex) * ocean->h0.size());
+            OceanSpectrumCache_Commit(entry);
+        }
+    }
+    // Dispersion table, as in the GPU path
+    const float twoPiOverDomain = static_cast<float>(2.0 * M_PI) / std::fmax(ocean->params.domainSize, 1.0f);
+    ocean->omega.resize(halfSize);
+    for (int v = 0; v < ocean->N; ++v)
+    {
+        float ky = (v < ocean->N / 2 ? v : v - ocean->N) * twoPiOverDomain;
+        for (int u = 0; u <= ocean->N / 2; ++u)
+        {
+            float kx = (u < ocean->N / 2 ? u : u - ocean->N) * twoPiOverDomain;
+            ocean->omega[static_cast<size_t>(v) * (ocean->N / 2 + 1) + u] =
+                std::sqrt(ocean->params.gravity * std::sqrt(kx * kx + ky * ky));
+        }
+    }
+    ocean->spectra.resize(kSpecCount * halfSize);
+    ocean->fields.assign(kOceanFieldCount * fieldSize, 0.0f);
+    return ocean;
+}
+
+void OceanCPU_Destroy(OceanCPU *ocean)
+{
+    if (!ocean)
+        return;
+    destroyFFTPlanCPU(ocean->plan);
+    delete ocean;
+}
+
+void OceanCPU_Update(OceanCPU *ocean, float seconds)
+{
+    if (!ocean)
+        return;
+
+    const int N = ocean->N;
+    const float t = seconds * ocean->params.time_scale;
+
+    // 1) Evolve H(k,t) and build slope/displacement spectra in one pass
+    ThreadPool_ParallelFor(ocean->pool, N, kRowGrain, [&](int begin, int end, int)
+    {
+        buildSpectraRows(ocean, t, begin, end);
+    });
+
+    // 2) Complex-to-real inverse FFT of all half spectra straight into the output fields
+    executeIFFT2DC2RBatchCPU(ocean->plan, ocean->spectra.data(), ocean->fields.data(), kSpecCount, ocean->pool);
+
+    // 3) Normalize the real fields
+    ThreadPool_ParallelFor(ocean->pool, N, kRowGrain, [&](int begin, int end, int)
+    {
+        normalizeRows(ocean, begin, end);
+    });
+
+    // 4) Jacobian from the extracted displacement
+    ThreadPool_ParallelFor(ocean->pool, N, kRowGrain, [&](int begin, int end, int)
+    {
+        jacobianRows(ocean, begin, end);
+    });
+}
+
+const float *OceanCPU_GetField(const OceanCPU *ocean, OceanField field)
+{
+    if (!ocean || field < 0 || field >= kOceanFieldCount)
+        return nullptr;
+    return ocean->fields.data() + static_cast<size_t>(field) * ocean->N * ocean->N;
+}
+
+const OceanInitParams &OceanCPU_GetParams(const OceanCPU *ocean)
+{
+    return ocean->params;
+}
@@ -1,99 +1,178 @@
-#include <algorithm>
+#include <stdio.h>
 #include <cmath>
+#include <cstddef>
 #include <random>
 #include <vector>
 
-#include "MicroGlut.h"
 #include "GL_utilities.h"
+#include "fft_complex.h"
+#include "fft_gpu.h"
 #include "ocean.h"
 #include "ocean_spectrum.h"
-
-#ifndef M_SQRT1_2
-#define M_SQRT1_2 0.70710678118654752440f
-#endif
+#include "ocean_spectrum_cache.h"
+#include "thread_pool.h"
 
 GLuint ssboH0 = 0;
-GLuint ssboHt = 0;
 
 int g_fftResolution = 256; // current resolution backing the SSBOs
+static int g_cascadeCount = 1; // cascades stored back to back in ssboH0
 
-struct Complex
-{
-    float r, i;
-};
+static GLuint h0Program = 0; // ocean_h0.comp, 0 -> CPU generation and upload
+static ThreadPool *h0Pool = nullptr; // CPU generation only, from ocean_init to ocean_release
+
+// JONSWAP spectrum and H0 generation live in ocean_spectrum.cpp
 
-static inline float v2_length(const OceanVec2 &v)
+static size_t HalfBins(int N)
 {
-    return sqrtf(v.x * v.x + v.y * v.y);
+    return static_cast<size_t>(N) * (N / 2 + 1);
 }
 
-static inline OceanVec2 v2_normalize(const OceanVec2 &v)
+// Bytes of one cascade's H0 pairs; cascades are stored back to back in ssboH0.
+static size_t CascadeBytes()
 {
-    float l = v2_length(v);
-    if (l <= 1e-8f)
-        return {0.0f, 0.0f};
-    return {v.x / l, v.y / l};
+    return sizeof(Complex) * 2 * HalfBins(g_fftResolution);
 }
 
-static inline float v2_dot(const OceanVec2 &a, const OceanVec2 &b)
+// Fills ssboH0 for every cascade with one dispatch of ocean_h0.comp.
+static void GenerateH0GPU(const OceanInitParams &params)
 {
-    return a.x * b.x + a.y * b.y;
+    float windX = params.windDirection.x;
+    float windY = params.windDirection.y;
+    float windLength = std::sqrt(windX * windX + windY * windY);
+    if (windLength > 1e-8f)
+    {
+        windX /= windLength;
+        windY /= windLength;
+    }
+    else
+    {
+        windX = 1.0f;
+        windY = 0.0f;
+    }
+
+    float domainSizes[kOceanMaxCascades], lowCutoffs[kOceanMaxCascades], highCutoffs[kOceanMaxCascades];
+    GLuint seeds[kOceanMaxCascades];
+    for (int c = 0; c < g_cascadeCount; ++c)
+    {
+        OceanInitParams cascade = Ocean_CascadeParams(params, c);
+        domainSizes[c] = cascade.domainSize;
+        lowCutoffs[c] = cascade.lowCutoff;
+        highCutoffs[c] = cascade.highCutoff;
+        seeds[c] = cascade.randomSeed;
+    }
+
+    glUseProgram(h0Program);
+    glUniform1i(glGetUniformLocation(h0Program, "u_N"), g_fftResolution);
+    glUniform1fv(glGetUniformLocation(h0Program, "u_domainSizes"), g_cascadeCount, domainSizes);
+    glUniform2f(glGetUniformLocation(h0Program, "u_windDir"), windX, windY);
+    glUniform1f(glGetUniformLocation(h0Program, "u_windSpeed"), params.windSpeed);
+    glUniform1f(glGetUniformLocation(h0Program, "u_alpha"), params.alpha);
+    glUniform1f(glGetUniformLocation(h0Program, "u_gamma"), params.gamma);
+    glUniform1f(glGetUniformLocation(h0Program, "u_spreadExponent"), params.spreadExponent);
+    glUniform1fv(glGetUniformLocation(h0Program, "u_lowCutoffs"), g_cascadeCount, lowCutoffs);
+    glUniform1fv(glGetUniformLocation(h0Program, "u_highCutoffs"), g_cascadeCount, highCutoffs);
+    glUniform1f(glGetUniformLocation(h0Program, "u_gravity"), params.gravity);
+    glUniform1uiv(glGetUniformLocation(h0Program, "u_seeds"), g_cascadeCount, seeds);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, ssboH0);
+
+    const int groups = static_cast<int>((HalfBins(g_fftResolution) + 256 - 1) / 256);
+    glDispatchCompute(groups, g_cascadeCount, 1);
+    glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
 }
 
-// JONSWAP spectrum and helpers moved to ocean_spectrum.cpp
+// Fallback when the compute shader is unavailable: generate on the CPU and upload.
+static void GenerateH0CPU(const OceanInitParams &params)
+{
+    std::vector<Complex> H0(static_cast<size_t>(g_fftResolution) * static_cast<size_t>(g_fftResolution));
+    std::vector<Complex> H0pairs(2 * HalfBins(g_fftResolution));
+    // H0 rows are independent and the result does not depend on the split
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, ssboH0);
+    for (int c = 0; c < g_cascadeCount; ++c)
+    {
+        Ocean_GenerateH0(Ocean_CascadeParams(params, c), H0.data(), h0Pool);
 
-void ocean_init(const OceanInitParams &userParams)
+        // Only the half spectrum is evolved; each bin keeps its (h0(k), h0(-k)) pair
+        Ocean_PackHalfSpectrumH0(g_fftResolution, H0.data(), H0pairs.data());
+        glBufferSubData(GL_SHADER_STORAGE_BUFFER, c * CascadeBytes(), CascadeBytes(), H0pairs.data());
+    }
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+}
+
+// Regenerates H0 of every cascade for new spectrum parameters at the current resolution.
+void ocean_generate_h0(const OceanInitParams &userParams)
 {
     OceanInitParams params = userParams;
+    if (params.randomSeed == 0)
+        params.randomSeed = std::random_device{}();
 
-    g_fftResolution = params.resolution;
+    if (h0Program)
+        GenerateH0GPU(params);
+    else
+        GenerateH0CPU(params);
+}
 
-    std::vector<Complex> H0(static_cast<size_t>(g_fftResolution) * static_cast<size_t>(g_fftResolution));
+// Frees the H0 buffer and the CPU generator's pool; the compiled H0 program is kept for the next init.
+void ocean_release()
+{
+    if (ssboH0)
+        glDeleteBuffers(1, &ssboH0);
+    ssboH0 = 0;
+    ThreadPool_Destroy(h0Pool);
+    h0Pool = nullptr;
+}
 
-    std::mt19937 rng(params.randomSeed ? params.randomSeed : std::random_device{}());
-    std::normal_distribution<float> gauss(0.0f, 1.0f);
+void ocean_init(const OceanInitParams &params)
+{
+    g_fftResolution = params.resolution;
+    g_cascadeCount = params.cascadeCount;
 
-    const float domain = params.domainSize;
-    const float twoPiOverDomain = 2.0f * 3.1415926f / domain;
+    if (!h0Program)
+    {
+        h0Program = loadComputeShader("shaders/ocean_h0.comp");
+        if (!h0Program)
+            printf("H0 compute shader unavailable, generating the spectrum on the CPU.\n");
+    }
+    // Kept for the spectrum changes of this init, which regenerate H0 on every wind delta
+    if (!h0Program && !h0Pool)
+        h0Pool = ThreadPool_Create();
 
-    OceanVec2 windDirNormalized = v2_normalize(params.windDirection);
-    if (v2_length(windDirNormalized) <= 1e-6f)
-        windDirNormalized = {1.0f, 0.0f};
+    // --- Allocate buffers ---
+    glGenBuffers(1, &ssboH0);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, ssboH0);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, g_cascadeCount * CascadeBytes(), nullptr, GL_STATIC_DRAW);
 
-    for (int y = 0; y < g_fftResolution; ++y)
+    // Cache hits are uploaded straight from the mapped files, one entry per cascade. Only entries
+    // of the generator this context would use count as hits.
+    const OceanSpectrumGenerator generator = h0Program ? kOceanSpectrumGeneratorGPU : kOceanSpectrumGeneratorCPU;
+    bool allCached = true;
+    for (int c = 0; c < g_cascadeCount; ++c)
     {
-        for (int x = 0; x < g_fftResolution; ++x)
+        OceanSpectrumCacheEntry *cached = OceanSpectrumCache_Open(Ocean_CascadeParams(params, c), generator);
+        if (!cached)
         {
-            int idx = y * g_fftResolution + x;
-
-            OceanVec2 k = {
-                (x - g_fftResolution / 2) * twoPiOverDomain,
-                (y - g_fftResolution / 2) * twoPiOverDomain};
-
-            float spectrum = Ocean_JONSWAP_Spectrum(k, params);
-
-            float P = sqrtf(std::max(spectrum, 0.0f));
-
-            float Er = gauss(rng);
-            float Ei = gauss(rng);
-
-            H0[idx].r = Er * P * M_SQRT1_2;
-            H0[idx].i = Ei * P * M_SQRT1_2;
+            allCached = false;
+            break;
         }
+        glBufferSubData(GL_SHADER_STORAGE_BUFFER, c * CascadeBytes(), CascadeBytes(), OceanSpectrumCache_Pairs(cached));
+        OceanSpectrumCache_Close(cached);
     }
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+    if (allCached)
+        return;
 
-    // --- Upload buffers ---
-    glGenBuffers(1, &ssboH0);
-    glBindBuffer(GL_SHADER_STORAGE_BUFFER, ssboH0);
-    glBufferData(GL_SHADER_STORAGE_BUFFER,
-                 sizeof(Complex) * g_fftResolution * g_fftResolution,
-                 H0.data(), GL_STATIC_DRAW);
-
-    glGenBuffers(1, &ssboHt);
-    glBindBuffer(GL_SHADER_STORAGE_BUFFER, ssboHt);
-    glBufferData(GL_SHADER_STORAGE_BUFFER,
-                 sizeof(Complex) * g_fftResolution * g_fftResolution,
-                 nullptr, GL_DYNAMIC_DRAW);
+    ocean_generate_h0(params);
 
+    // Read the generated spectra back into new cache files for the next launch
+    glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, ssboH0);
+    for (int c = 0; c < g_cascadeCount; ++c)
+    {
+        Complex *pairs = nullptr;
+        OceanSpectrumCacheEntry *entry = OceanSpectrumCache_Create(Ocean_CascadeParams(params, c), generator, &pairs);
+        if (!entry)
+            continue;
+        glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, c * CascadeBytes(), CascadeBytes(), pairs);
+        OceanSpectrumCache_Commit(entry);
+    }
     glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
-}
\ No newline at end of file
+}
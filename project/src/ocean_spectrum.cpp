@@ -1,7 +1,23 @@
 #include <algorithm>
 #include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <random>
+#include <vector>
 
-#include "ocean.h"
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+#include "fft_complex.h"
+#include "ocean_params.h"
+#include "ocean_spectrum.h"
+#include "thread_pool.h"
+
+#ifndef M_SQRT1_2
+#define M_SQRT1_2 0.70710678118654752440f
+#endif
 
 static inline float v2_length_s(const OceanVec2 &v)
 {
@@ -107,3 +123,392 @@ float Ocean_JONSWAP_Spectrum(const OceanVec2 &k,
                           params.highCutoff,
                           params.gravity);
 }
+
+// ---------------------------------------------------------------------------------------------
+// Batch evaluation. With omega = sqrt(g k) the model folds into
+//   S(k) = 0.5 * alpha / k^3 * exp(E),
+//   E = -beta * omega_p^4 / (g^2 k^2) + ln(gamma) * exp(-r^2 / 2) - (lowCutoff / k)^2
+//       - (k / highCutoff)^2 + spreadExponent * ln(cos theta)
+// so each wave-vector costs one sqrt, two divisions, two exps and one log; everything else
+// depends only on the parameters and is computed once per batch.
+
+struct JonswapConstants
+{
+    float halfAlpha;
+    float negBetaWp4OverG2; // -beta * omega_p^4 / g^2
+    float gravity;
+    float omegaP;
+    float kPeak;            // omega_p^2 / g: sigma switches here
+    float invSigmaLow;      // 1 / (0.07 omega_p)
+    float invSigmaHigh;     // 1 / (0.09 omega_p)
+    float lnGamma;
+    float lowCutoff;        // 0 disables
+    float invHighCutoff;    // 0 disables
+    float spread;           // 0 disables
+    float windX;
+    float windY;
+};
+
+// Returns false when the batch path cannot reproduce the scalar model (or the result is all zero).
+static bool prepareJonswap(const OceanInitParams &params, JonswapConstants &c, bool &allZero)
+{
+    allZero = !(params.windSpeed > 0.0f) || !(std::isfinite(params.gravity) && params.gravity > 0.0f) ||
+              params.alpha <= 0.0f;
+    if (allZero)
+        return true;
+    if (!(params.gamma > 0.0f))
+        return false;
+
+    const float g = params.gravity;
+    const float wp = 0.877f * g / params.windSpeed;
+    c.halfAlpha = 0.5f * params.alpha;
+    c.negBetaWp4OverG2 = -1.25f * (wp * wp) * (wp * wp) / (g * g);
+    c.gravity = g;
+    c.omegaP = wp;
+    c.kPeak = wp * wp / g;
+    c.invSigmaLow = 1.0f / (0.07f * wp);
+    c.invSigmaHigh = 1.0f / (0.09f * wp);
+    c.lnGamma = std::log(params.gamma);
+    c.lowCutoff = params.lowCutoff > 0.0f ? params.lowCutoff : 0.0f;
+    c.invHighCutoff = params.highCutoff > 0.0f ? 1.0f / params.highCutoff : 0.0f;
+    c.spread = params.spreadExponent > 0.0f ? params.spreadExponent : 0.0f;
+
+    OceanVec2 wind = v2_normalize_s(params.windDirection);
+    if (v2_length_s(wind) <= 1e-6f)
+        wind = {1.0f, 0.0f};
+    c.windX = wind.x;
+    c.windY = wind.y;
+    return true;
+}
+
+// exp(x): Cody-Waite reduction to r in [-ln2/2, ln2/2] and the Cephes expf polynomial.
+// Relative error <= 1e-7 on [-87, 88] (measured 8.2e-8); returns 0 below -87 and clamps above 88.
+static const float kExpLow = -87.0f;
+static const float kExpHigh = 88.0f;
+static const float kLog2e = 1.44269504089f;
+static const float kLn2Hi = 0.693359375f;
+static const float kLn2Lo = -2.12194440e-4f;
+static const float kExpP[6] = {1.9875691500e-4f, 1.3981999507e-3f, 8.3334519073e-3f,
+                               4.1665795894e-2f, 1.6666665459e-1f, 5.0000001201e-1f};
+
+// ln(x) for normal x > 0: x = 2^e * m with m in [sqrt(1/2), sqrt(2)), ln m = 2 atanh(s),
+// s = (m - 1) / (m + 1), |s| <= 0.172, series through s^9. Error <= 3e-7 absolute on
+// [1e-3, 4] (measured 2.9e-7) and <= 1e-7 relative below that.
+static const float kLn2 = 0.693147180560f;
+static const float kSqrt2 = 1.41421356237f;
+
+static inline float fastExp(float x)
+{
+    if (x < kExpLow)
+        return 0.0f;
+    x = std::min(x, kExpHigh);
+    float n = std::nearbyint(x * kLog2e);
+    float r = x - n * kLn2Hi - n * kLn2Lo;
+    float p = kExpP[0];
+    for (int i = 1; i < 6; ++i)
+        p = p * r + kExpP[i];
+    float e = p * (r * r) + r + 1.0f;
+    int32_t bits = (static_cast<int32_t>(n) + 127) << 23;
+    float scale;
+    memcpy(&scale, &bits, sizeof(scale));
+    return e * scale;
+}
+
+static inline float fastLog(float x)
+{
+    int32_t bits;
+    memcpy(&bits, &x, sizeof(bits));
+    float e = static_cast<float>(((bits >> 23) & 255) - 127);
+    bits = (bits & 0x007fffff) | 0x3f800000;
+    float m;
+    memcpy(&m, &bits, sizeof(m));
+    if (m > kSqrt2)
+    {
+        m *= 0.5f;
+        e += 1.0f;
+    }
+    float s = (m - 1.0f) / (m + 1.0f);
+    float z = s * s;
+    float poly = 1.0f + z * (1.0f / 3.0f + z * (1.0f / 5.0f + z * (1.0f / 7.0f + z * (1.0f / 9.0f))));
+    return e * kLn2 + 2.0f * s * poly;
+}
+
+static inline float jonswapLane(const JonswapConstants &c, float kx, float ky)
+{
+    float k = std::sqrt(kx * kx + ky * ky);
+    float cosTheta = (kx * c.windX + ky * c.windY) / k;
+    if (!(k >= 1e-6f) || (c.spread > 0.0f && !(cosTheta > 0.0f)))
+        return 0.0f;
+
+    float invK = 1.0f / k;
+    float omega = std::sqrt(c.gravity * k);
+    float r = (omega - c.omegaP) * (k <= c.kPeak ? c.invSigmaLow : c.invSigmaHigh);
+    float lowRatio = c.lowCutoff * invK;
+    float highRatio = k * c.invHighCutoff;
+    float E = c.negBetaWp4OverG2 * invK * invK + c.lnGamma * fastExp(-0.5f * r * r) -
+              lowRatio * lowRatio - highRatio * highRatio;
+    if (c.spread > 0.0f)
+        E += c.spread * fastLog(cosTheta);
+    return c.halfAlpha * invK * invK * invK * fastExp(E);
+}
+
+#if defined(__AVX2__)
+
+static const int kJonswapLanes = 8;
+
+static inline __m256 fastExp8(__m256 x)
+{
+    __m256 underflow = _mm256_cmp_ps(x, _mm256_set1_ps(kExpLow), _CMP_LT_OQ);
+    x = _mm256_max_ps(_mm256_min_ps(x, _mm256_set1_ps(kExpHigh)), _mm256_set1_ps(kExpLow));
+    __m256 n = _mm256_round_ps(_mm256_mul_ps(x, _mm256_set1_ps(kLog2e)), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+    __m256 r = _mm256_sub_ps(x, _mm256_mul_ps(n, _mm256_set1_ps(kLn2Hi)));
+    r = _mm256_sub_ps(r, _mm256_mul_ps(n, _mm256_set1_ps(kLn2Lo)));
+    __m256 p = _mm256_set1_ps(kExpP[0]);
+    for (int i = 1; i < 6; ++i)
+        p = _mm256_add_ps(_mm256_mul_ps(p, r), _mm256_set1_ps(kExpP[i]));
+    __m256 e = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(p, _mm256_mul_ps(r, r)), r), _mm256_set1_ps(1.0f));
+    __m256i bits = _mm256_slli_epi32(_mm256_add_epi32(_mm256_cvtps_epi32(n), _mm256_set1_epi32(127)), 23);
+    return _mm256_andnot_ps(underflow, _mm256_mul_ps(e, _mm256_castsi256_ps(bits)));
+}
+
+static inline __m256 fastLog8(__m256 x)
+{
+    __m256i bits = _mm256_castps_si256(x);
+    __m256i exponent = _mm256_sub_epi32(_mm256_and_si256(_mm256_srli_epi32(bits, 23), _mm256_set1_epi32(255)),
+                                        _mm256_set1_epi32(127));
+    __m256 e = _mm256_cvtepi32_ps(exponent);
+    __m256 m = _mm256_castsi256_ps(_mm256_or_si256(_mm256_and_si256(bits, _mm256_set1_epi32(0x007fffff)),
+                                                   _mm256_set1_epi32(0x3f800000)));
+    __m256 big = _mm256_cmp_ps(m, _mm256_set1_ps(kSqrt2), _CMP_GT_OQ);
+    m = _mm256_blendv_ps(m, _mm256_mul_ps(m, _mm256_set1_ps(0.5f)), big);
+    e = _mm256_add_ps(e, _mm256_and_ps(big, _mm256_set1_ps(1.0f)));
+    __m256 one = _mm256_set1_ps(1.0f);
+    __m256 s = _mm256_div_ps(_mm256_sub_ps(m, one), _mm256_add_ps(m, one));
+    __m256 z = _mm256_mul_ps(s, s);
+    __m256 poly = _mm256_set1_ps(1.0f / 9.0f);
+    poly = _mm256_add_ps(_mm256_mul_ps(poly, z), _mm256_set1_ps(1.0f / 7.0f));
+    poly = _mm256_add_ps(_mm256_mul_ps(poly, z), _mm256_set1_ps(1.0f / 5.0f));
+    poly = _mm256_add_ps(_mm256_mul_ps(poly, z), _mm256_set1_ps(1.0f / 3.0f));
+    poly = _mm256_add_ps(_mm256_mul_ps(poly, z), one);
+    return _mm256_add_ps(_mm256_mul_ps(e, _mm256_set1_ps(kLn2)),
+                         _mm256_mul_ps(_mm256_add_ps(s, s), poly));
+}
+
+// Eight wave-vectors; same formula as jonswapLane.
+static inline void jonswap8(const JonswapConstants &c, const float *kxIn, const float *kyIn, float *out)
+{
+    __m256 kx = _mm256_loadu_ps(kxIn);
+    __m256 ky = _mm256_loadu_ps(kyIn);
+    __m256 k = _mm256_sqrt_ps(_mm256_add_ps(_mm256_mul_ps(kx, kx), _mm256_mul_ps(ky, ky)));
+    __m256 cosTheta = _mm256_div_ps(_mm256_add_ps(_mm256_mul_ps(kx, _mm256_set1_ps(c.windX)),
+                                                  _mm256_mul_ps(ky, _mm256_set1_ps(c.windY))),
+                                    k);
+    __m256 zero = _mm256_cmp_ps(k, _mm256_set1_ps(1e-6f), _CMP_NGE_UQ);
+    if (c.spread > 0.0f)
+        zero = _mm256_or_ps(zero, _mm256_cmp_ps(cosTheta, _mm256_setzero_ps(), _CMP_NGT_UQ));
+
+    __m256 invK = _mm256_div_ps(_mm256_set1_ps(1.0f), k);
+    __m256 omega = _mm256_sqrt_ps(_mm256_mul_ps(_mm256_set1_ps(c.gravity), k));
+    __m256 invSigma = _mm256_blendv_ps(_mm256_set1_ps(c.invSigmaHigh), _mm256_set1_ps(c.invSigmaLow),
+                                       _mm256_cmp_ps(k, _mm256_set1_ps(c.kPeak), _CMP_LE_OQ));
+    __m256 r = _mm256_mul_ps(_mm256_sub_ps(omega, _mm256_set1_ps(c.omegaP)), invSigma);
+    __m256 lowRatio = _mm256_mul_ps(_mm256_set1_ps(c.lowCutoff), invK);
+    __m256 highRatio = _mm256_mul_ps(k, _mm256_set1_ps(c.invHighCutoff));
+    __m256 invK2 = _mm256_mul_ps(invK, invK);
+
+    __m256 E = _mm256_mul_ps(_mm256_set1_ps(c.negBetaWp4OverG2), invK2);
+    __m256 peak = fastExp8(_mm256_mul_ps(_mm256_set1_ps(-0.5f), _mm256_mul_ps(r, r)));
+    E = _mm256_add_ps(E, _mm256_mul_ps(_mm256_set1_ps(c.lnGamma), peak));
+    E = _mm256_sub_ps(E, _mm256_mul_ps(lowRatio, lowRatio));
+    E = _mm256_sub_ps(E, _mm256_mul_ps(highRatio, highRatio));
+    if (c.spread > 0.0f)
+        E = _mm256_add_ps(E, _mm256_mul_ps(_mm256_set1_ps(c.spread), fastLog8(cosTheta)));
+
+    __m256 S = _mm256_mul_ps(_mm256_mul_ps(_mm256_set1_ps(c.halfAlpha), _mm256_mul_ps(invK2, invK)), fastExp8(E));
+    _mm256_storeu_ps(out, _mm256_andnot_ps(zero, S));
+}
+
+#endif
+
+// Every element goes through the same instruction sequence whatever its position (the tail is
+// padded to a full vector), so results do not depend on how a grid is split into batches.
+static void evalJonswap(const JonswapConstants &c, const float *kx, const float *ky, int count, float *out)
+{
+#if defined(__AVX2__)
+    int i = 0;
+    for (; i + kJonswapLanes <= count; i += kJonswapLanes)
+        jonswap8(c, kx + i, ky + i, out + i);
+    if (i < count)
+    {
+        float kxTail[kJonswapLanes] = {};
+        float kyTail[kJonswapLanes] = {};
+        float outTail[kJonswapLanes];
+        memcpy(kxTail, kx + i, (count - i) * sizeof(float));
+        memcpy(kyTail, ky + i, (count - i) * sizeof(float));
+        jonswap8(c, kxTail, kyTail, outTail);
+        memcpy(out + i, outTail, (count - i) * sizeof(float));
+    }
+#else
+    for (int i = 0; i < count; ++i)
+        out[i] = jonswapLane(c, kx[i], ky[i]);
+#endif
+}
+
+void Ocean_JONSWAP_SpectrumBatch(const float *kx, const float *ky, int count,
+                                 const OceanInitParams &params, float *out)
+{
+    JonswapConstants c;
+    bool allZero = false;
+    if (!prepareJonswap(params, c, allZero))
+    {
+        for (int i = 0; i < count; ++i)
+            out[i] = Ocean_JONSWAP_Spectrum({kx[i], ky[i]}, params);
+        return;
+    }
+    if (allZero)
+    {
+        std::fill(out, out + count, 0.0f);
+        return;
+    }
+    evalJonswap(c, kx, ky, count, out);
+}
+
+void Ocean_JONSWAP_SpectrumGrid(const OceanSpectrumGrid &grid, const OceanInitParams &params, float *out)
+{
+    if (grid.width <= 0 || grid.height <= 0)
+        return;
+
+    std::vector<float> kx(grid.width);
+    std::vector<float> ky(grid.width);
+    for (int x = 0; x < grid.width; ++x)
+        kx[x] = grid.kx0 + x * grid.dk;
+    for (int y = 0; y < grid.height; ++y)
+    {
+        std::fill(ky.begin(), ky.end(), grid.ky0 + y * grid.dk);
+        Ocean_JONSWAP_SpectrumBatch(kx.data(), ky.data(), grid.width, params, out + static_cast<size_t>(y) * grid.width);
+    }
+}
+
+// Philox4x32-10 (Salmon et al., "Parallel random numbers: as easy as 1, 2, 3"): a counter-based
+// generator, so the draws for texel (x, y) depend only on the seed and (x, y), never on the order
+// in which texels are visited.
+struct Philox4x32
+{
+    uint32_t v[4];
+};
+
+static inline uint32_t mulHiLo(uint32_t a, uint32_t b, uint32_t &hi)
+{
+    uint64_t product = static_cast<uint64_t>(a) * b;
+    hi = static_cast<uint32_t>(product >> 32);
+    return static_cast<uint32_t>(product);
+}
+
+static Philox4x32 philox4x32(Philox4x32 counter, uint32_t key0, uint32_t key1)
+{
+    for (int round = 0; round < 10; ++round)
+    {
+        uint32_t hi0, hi1;
+        uint32_t lo0 = mulHiLo(0xD2511F53u, counter.v[0], hi0);
+        uint32_t lo1 = mulHiLo(0xCD9E8D57u, counter.v[2], hi1);
+        counter = {{hi1 ^ counter.v[1] ^ key0, lo1, hi0 ^ counter.v[3] ^ key1, lo0}};
+        key0 += 0x9E3779B9u;
+        key1 += 0xBB67AE85u;
+    }
+    return counter;
+}
+
+static const uint32_t kH0StreamKey = 0x4f43454eu; // "OCEN": separates H0 draws from other streams
+
+// Two independent standard normal draws for texel (x, y) via Box-Muller.
+static inline void gaussianPair(uint32_t seed, int x, int y, float &g0, float &g1)
+{
+    Philox4x32 bits = philox4x32({{static_cast<uint32_t>(x), static_cast<uint32_t>(y), 0u, 0u}}, seed, kH0StreamKey);
+    const float u0 = ((bits.v[0] >> 8) + 1u) * (1.0f / 16777216.0f); // (0, 1]
+    const float u1 = (bits.v[1] >> 8) * (1.0f / 16777216.0f);         // [0, 1)
+    const float radius = std::sqrt(-2.0f * std::log(u0));
+    const float angle = 6.28318530718f * u1;
+    g0 = radius * std::cos(angle);
+    g1 = radius * std::sin(angle);
+}
+
+static const int kH0RowGrain = 8;
+
+void Ocean_GenerateH0(const OceanInitParams &params, Complex *H0, ThreadPool *pool)
+{
+    const int N = params.resolution;
+    const uint32_t seed = params.randomSeed ? params.randomSeed : std::random_device{}();
+
+    const float domain = params.domainSize;
+    const float twoPiOverDomain = 2.0f * 3.1415926f / domain;
+
+    // Every texel depends only on (seed, x, y) and each row's spectrum is one batch of the same
+    // kx values, so the result is bit-identical for any thread count or row split.
+    ThreadPool_ParallelFor(pool, N, kH0RowGrain, [&](int begin, int end, int)
+    {
+        std::vector<float> kx(N), ky(N), spectrum(N);
+        for (int x = 0; x < N; ++x)
+            kx[x] = (x - N / 2) * twoPiOverDomain;
+
+        for (int y = begin; y < end; ++y)
+        {
+            std::fill(ky.begin(), ky.end(), (y - N / 2) * twoPiOverDomain);
+            Ocean_JONSWAP_SpectrumBatch(kx.data(), ky.data(), N, params, spectrum.data());
+
+            for (int x = 0; x < N; ++x)
+            {
+                size_t idx = static_cast<size_t>(y) * N + x;
+
+                float P = sqrtf(std::max(spectrum[x], 0.0f));
+
+                float Er, Ei;
+                gaussianPair(seed, x, y, Er, Ei);
+
+                H0[idx].x = Er * P * M_SQRT1_2;
+                H0[idx].y = Ei * P * M_SQRT1_2;
+            }
+        }
+    });
+}
+
+OceanInitParams Ocean_CascadeParams(const OceanInitParams &params, int cascade)
+{
+    OceanInitParams result = params;
+    const OceanInitParams defaults;
+    result.cascadeCount = 1;
+    for (int i = 0; i < kOceanMaxCascades - 1; ++i)
+        result.detailCascades[i] = defaults.detailCascades[i];
+    if (cascade <= 0)
+        return result;
+
+    const OceanCascadeParams &detail = params.detailCascades[cascade - 1];
+    result.domainSize = detail.domainSize;
+    result.lowCutoff = detail.lowCutoff;
+    result.highCutoff = detail.highCutoff;
+    if (params.randomSeed != 0)
+    {
+        result.randomSeed = params.randomSeed + static_cast<uint32_t>(cascade) * 0x9E3779B9u;
+        if (result.randomSeed == 0)
+            result.randomSeed = 1;
+    }
+    return result;
+}
+
+void Ocean_PackHalfSpectrumH0(int N, const Complex *H0, Complex *pairs)
+{
+    const int bins = N / 2 + 1;
+    for (int v = 0; v < N; ++v)
+    {
+        // FFT-order index -> centered index: k = u (or u - N), stored at k + N/2
+        const int y = (v + N / 2) % N;
+        const int ym = (N - y) % N;
+        for (int u = 0; u < bins; ++u)
+        {
+            const int x = (u + N / 2) % N;
+            const int xm = (N - x) % N;
+            const size_t id = static_cast<size_t>(v) * bins + u;
+            pairs[2 * id] = H0[y * N + x];
+            pairs[2 * id + 1] = H0[ym * N + xm];
+        }
+    }
+}
@@ -0,0 +1,251 @@
+#include "ocean_spectrum_cache.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <string>
+
+#include "fft_complex.h"
+#include "ocean_params.h"
+
+// Bump whenever the file layout or the H0 generator output changes so stale files are ignored.
+static const uint32_t kCacheVersion = 2; // 2: per-generator entries
+
+// 64 bytes so the pairs that follow are cache-line aligned in the mapping
+struct SpectrumCacheHeader
+{
+    char magic[4];         // "OCH0"
+    uint32_t version;      // kCacheVersion
+    uint64_t key;          // OceanSpectrumCache_Key of the generating params
+    uint32_t resolution;   // N
+    uint32_t generator;    // OceanSpectrumGenerator
+    uint64_t payloadBytes; // sizeof(Complex) * 2 * N * (N/2 + 1)
+    uint8_t padding[32];
+};
+static_assert(sizeof(SpectrumCacheHeader) == 64, "cache header must stay 64 bytes");
+
+struct OceanSpectrumCacheEntry
+{
+    void *mapping = nullptr;
+    size_t mappingBytes = 0;
+    std::string path;     // final file name
+    std::string tempPath; // non-empty for created (writable) entries
+};
+
+static std::string g_cacheDir;
+static bool g_cacheDirSet = false;
+
+static const std::string &cacheDirectory()
+{
+    if (!g_cacheDirSet)
+    {
+        const char *env = getenv("OCEAN_SPECTRUM_CACHE");
+        g_cacheDir = env ? env : "out/cache";
+        g_cacheDirSet = true;
+    }
+    return g_cacheDir;
+}
+
+void OceanSpectrumCache_SetDirectory(const char *dir)
+{
+    g_cacheDir = dir ? dir : "";
+    g_cacheDirSet = true;
+}
+
+static void hashBytes(uint64_t &hash, const void *data, size_t size)
+{
+    const unsigned char *bytes = static_cast<const unsigned char *>(data);
+    for (size_t i = 0; i < size; ++i)
+    {
+        hash ^= bytes[i];
+        hash *= 1099511628211ull;
+    }
+}
+
+template <typename T>
+static void hashField(uint64_t &hash, const T &value)
+{
+    hashBytes(hash, &value, sizeof(value));
+}
+
+uint64_t OceanSpectrumCache_Key(const OceanInitParams &params, OceanSpectrumGenerator generator)
+{
+    // Field by field: struct padding must not leak into the key
+    uint64_t hash = 14695981039346656037ull;
+    hashField(hash, params.time_scale);
+    hashField(hash, params.resolution);
+    hashField(hash, params.domainSize);
+    hashField(hash, params.windDirection.x);
+    hashField(hash, params.windDirection.y);
+    hashField(hash, params.windSpeed);
+    hashField(hash, params.alpha);
+    hashField(hash, params.gamma);
+    hashField(hash, params.spreadExponent);
+    hashField(hash, params.lowCutoff);
+    hashField(hash, params.highCutoff);
+    hashField(hash, params.gravity);
+    hashField(hash, params.amplitudeScale);
+    hashField(hash, params.choppiness);
+    hashField(hash, params.randomSeed);
+    hashField(hash, params.cascadeCount);
+    for (const OceanCascadeParams &cascade : params.detailCascades)
+    {
+        hashField(hash, cascade.domainSize);
+        hashField(hash, cascade.lowCutoff);
+        hashField(hash, cascade.highCutoff);
+    }
+    hashField(hash, static_cast<uint32_t>(generator));
+    return hash;
+}
+
+static size_t payloadBytes(int N)
+{
+    return sizeof(Complex) * 2 * static_cast<size_t>(N) * (N / 2 + 1);
+}
+
+static bool cacheable(const OceanInitParams &params)
+{
+    return params.randomSeed != 0 && params.resolution > 0 && !cacheDirectory().empty();
+}
+
+static std::string entryPath(uint64_t key)
+{
+    char name[64];
+    snprintf(name, sizeof(name), "/h0_%016llx.bin", static_cast<unsigned long long>(key));
+    return cacheDirectory() + name;
+}
+
+// mkdir -p
+static bool makeDirectories(const std::string &dir)
+{
+    for (size_t slash = dir.find('/', 1); ; slash = dir.find('/', slash + 1))
+    {
+        std::string prefix = dir.substr(0, slash);
+        if (mkdir(prefix.c_str(), 0755) != 0 && errno != EEXIST)
+            return false;
+        if (slash == std::string::npos)
+            return true;
+    }
+}
+
+OceanSpectrumCacheEntry *OceanSpectrumCache_Open(const OceanInitParams &params, OceanSpectrumGenerator generator)
+{
+    if (!cacheable(params))
+        return nullptr;
+
+    const uint64_t key = OceanSpectrumCache_Key(params, generator);
+    const std::string path = entryPath(key);
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        return nullptr;
+
+    const size_t expected = sizeof(SpectrumCacheHeader) + payloadBytes(params.resolution);
+    struct stat info;
+    void *mapping = MAP_FAILED;
+    if (fstat(fd, &info) == 0 && static_cast<size_t>(info.st_size) == expected)
+        mapping = mmap(nullptr, expected, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd); // the mapping keeps the file alive
+    if (mapping == MAP_FAILED)
+        return nullptr;
+
+    const SpectrumCacheHeader *header = static_cast<const SpectrumCacheHeader *>(mapping);
+    if (memcmp(header->magic, "OCH0", 4) != 0 || header->version != kCacheVersion ||
+        header->key != key || header->generator != static_cast<uint32_t>(generator) ||
+        header->resolution != static_cast<uint32_t>(params.resolution) ||
+        header->payloadBytes != payloadBytes(params.resolution))
+    {
+        printf("Ignoring stale spectrum cache file %s.\n", path.c_str());
+        munmap(mapping, expected);
+        return nullptr;
+    }
+
+    OceanSpectrumCacheEntry *entry = new OceanSpectrumCacheEntry;
+    entry->mapping = mapping;
+    entry->mappingBytes = expected;
+    entry->path = path;
+    return entry;
+}
+
+const Complex *OceanSpectrumCache_Pairs(const OceanSpectrumCacheEntry *entry)
+{
+    if (!entry)
+        return nullptr;
+    return reinterpret_cast<const Complex *>(static_cast<const char *>(entry->mapping) + sizeof(SpectrumCacheHeader));
+}
+
+OceanSpectrumCacheEntry *OceanSpectrumCache_Create(const OceanInitParams &params, OceanSpectrumGenerator generator,
+                                                   Complex **pairs)
+{
+    if (!pairs || !cacheable(params) || !makeDirectories(cacheDirectory()))
+        return nullptr;
+
+    const uint64_t key = OceanSpectrumCache_Key(params, generator);
+    const std::string path = entryPath(key);
+    char suffix[32];
+    snprintf(suffix, sizeof(suffix), ".tmp%d", static_cast<int>(getpid()));
+    const std::string tempPath = path + suffix;
+
+    const size_t bytes = sizeof(SpectrumCacheHeader) + payloadBytes(params.resolution);
+    int fd = open(tempPath.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0)
+        return nullptr;
+    void *mapping = MAP_FAILED;
+    if (ftruncate(fd, static_cast<off_t>(bytes)) == 0)
+        mapping = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED)
+    {
+        unlink(tempPath.c_str());
+        return nullptr;
+    }
+
+    SpectrumCacheHeader *header = static_cast<SpectrumCacheHeader *>(mapping);
+    memset(header, 0, sizeof(*header));
+    memcpy(header->magic, "OCH0", 4);
+    header->version = kCacheVersion;
+    header->key = key;
+    header->resolution = static_cast<uint32_t>(params.resolution);
+    header->generator = static_cast<uint32_t>(generator);
+    header->payloadBytes = payloadBytes(params.resolution);
+
+    OceanSpectrumCacheEntry *entry = new OceanSpectrumCacheEntry;
+    entry->mapping = mapping;
+    entry->mappingBytes = bytes;
+    entry->path = path;
+    entry->tempPath = tempPath;
+    *pairs = reinterpret_cast<Complex *>(static_cast<char *>(mapping) + sizeof(SpectrumCacheHeader));
+    return entry;
+}
+
+bool OceanSpectrumCache_Commit(OceanSpectrumCacheEntry *entry)
+{
+    if (!entry || entry->tempPath.empty())
+        return false;
+
+    munmap(entry->mapping, entry->mappingBytes);
+    entry->mapping = nullptr;
+    bool ok = rename(entry->tempPath.c_str(), entry->path.c_str()) == 0;
+    if (!ok)
+    {
+        printf("Could not publish spectrum cache file %s.\n", entry->path.c_str());
+        unlink(entry->tempPath.c_str());
+    }
+    delete entry;
+    return ok;
+}
+
+void OceanSpectrumCache_Close(OceanSpectrumCacheEntry *entry)
+{
+    if (!entry)
+        return;
+    if (entry->mapping)
+        munmap(entry->mapping, entry->mappingBytes);
+    if (!entry->tempPath.empty())
+        unlink(entry->tempPath.c_str());
+    delete entry;
+}
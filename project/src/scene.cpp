@@ -1,70 +1,136 @@
 #include "scene.h"
 
+#include <math.h>
 #include <stdlib.h>
+#include <vector>
 
 #include "VectorUtils4.h"
 
-Model *planeModel = nullptr;
+// Water clipmap: kClipmapLevels nested square grids centred on the camera, each with twice the cell
+// size of the previous one. Every level uses the same (2R + 1)^2 grid of integer cell coordinates
+// in [-R, R]; there is no vertex buffer, water.vert derives the coordinate from gl_VertexID and
+// places it in the world. Level 0 is drawn whole; coarser levels are rings around the hole filled
+// by the next finer level.
+static const int kClipmapHalfCells = 64;    // R, even so a finer level ends on coarse vertices
+static const int kClipmapLevels = 6;        // outermost level reaches R * cell * 2^5 = 1024 m
+static const float kClipmapCellSize = 0.5f; // level 0 cell size (m), about one FFT texel
 
-Model *CreateSubdividedPlane(int divisions, float size)
-{
-    int vertsPerSide = divisions + 1;
-    int numVertices = vertsPerSide * vertsPerSide;
-    int numIndices = divisions * divisions * 6; // two triangles per quad
+// Cells per column stripe. Strips run along a row of one stripe, so the next row's strip reuses
+// the 17 shared vertices while they are still in the post-transform cache.
+static const int kClipmapStripeCells = 16;
 
-    vec3 *vertices = (vec3 *)malloc(sizeof(vec3) * numVertices);
-    vec3 *normals = (vec3 *)malloc(sizeof(vec3) * numVertices);
-    vec2 *texCoords = (vec2 *)malloc(sizeof(vec2) * numVertices);
-    GLuint *indices = (GLuint *)malloc(sizeof(GLuint) * numIndices);
+// Index ranges in the shared element buffer: the full grid, then one ring per position of the
+// finer level inside the coarser one (offset -1, 0 or +1 coarse cells on each axis).
+struct ClipmapRange
+{
+    GLsizei count;
+    size_t offset; // bytes
+};
 
-    float half = size * 0.5f;
-    float step = size / divisions;
+static GLuint clipmapVAO = 0;
+static GLuint clipmapEBO = 0;
+static ClipmapRange clipmapFull;
+static ClipmapRange clipmapRings[3][3]; // [dz + 1][dx + 1]
 
-    int vi = 0;
-    for (int i = 0; i < vertsPerSide; i++)
+// Triangle strips, one per row segment of a stripe and separated by the restart index, covering
+// every cell except the hole [holeMin, holeMax) on both axes (empty hole for the full grid).
+// Strips alternate row i and row i + 1, which gives the same winding as the old triangle list.
+static void AppendClipmapStrips(std::vector<GLushort> &indices, int holeMinX, int holeMaxX, int holeMinZ, int holeMaxZ)
+{
+    const int cells = 2 * kClipmapHalfCells;
+    const int vertsPerSide = cells + 1;
+    for (int x0 = 0; x0 < cells; x0 += kClipmapStripeCells)
     {
-        for (int j = 0; j < vertsPerSide; j++)
+        int x1 = x0 + kClipmapStripeCells < cells ? x0 + kClipmapStripeCells : cells;
+        for (int i = 0; i < cells; i++)
         {
-            float x = -half + j * step;
-            float z = -half + i * step;
-            vertices[vi].x = x;
-            vertices[vi].y = 0.0f;
-            vertices[vi].z = z;
-            normals[vi].x = 0.0f;
-            normals[vi].y = 1.0f;
-            normals[vi].z = 0.0f;
-            float u = (float)j / (float)divisions;
-            float v = (float)i / (float)divisions;
-            const float repeat = 1.0f;
-            texCoords[vi].x = u * repeat;
-            texCoords[vi].y = v * repeat;
-            vi++;
+            bool holeRow = i >= holeMinZ && i < holeMaxZ;
+            int j = x0;
+            while (j < x1)
+            {
+                if (holeRow && j >= holeMinX && j < holeMaxX)
+                {
+                    j = holeMaxX;
+                    continue;
+                }
+                int end = (holeRow && holeMinX > j && holeMinX < x1) ? holeMinX : x1;
+                for (int k = j; k <= end; k++)
+                {
+                    indices.push_back((GLushort)(i * vertsPerSide + k));
+                    indices.push_back((GLushort)((i + 1) * vertsPerSide + k));
+                }
+                indices.push_back(0xFFFF); // GL_PRIMITIVE_RESTART_FIXED_INDEX for 16-bit indices
+                j = end;
+            }
         }
     }
+}
 
-    int ii = 0;
-    for (int i = 0; i < divisions; i++)
+static void InitWaterClipmap()
+{
+    const int R = kClipmapHalfCells;
+    static_assert((2 * kClipmapHalfCells + 1) * (2 * kClipmapHalfCells + 1) < 0xFFFF,
+                  "clipmap vertex ids must fit 16-bit indices below the restart index");
+
+    std::vector<GLushort> indices;
+    AppendClipmapStrips(indices, 0, 0, 0, 0);
+    clipmapFull = {(GLsizei)indices.size(), 0};
+
+    // The finer level covers R coarse cells around its own centre, which is within one coarse
+    // cell of this level's centre.
+    for (int dz = -1; dz <= 1; dz++)
     {
-        for (int j = 0; j < divisions; j++)
+        for (int dx = -1; dx <= 1; dx++)
         {
-            int v0 = i * vertsPerSide + j;
-            int v1 = v0 + 1;
-            int v2 = v0 + vertsPerSide;
-            int v3 = v2 + 1;
-            indices[ii++] = v0;
-            indices[ii++] = v2;
-            indices[ii++] = v1;
-            indices[ii++] = v2;
-            indices[ii++] = v3;
-            indices[ii++] = v1;
+            size_t first = indices.size();
+            AppendClipmapStrips(indices, R / 2 + dx, R / 2 + dx + R, R / 2 + dz, R / 2 + dz + R);
+            clipmapRings[dz + 1][dx + 1] = {(GLsizei)(indices.size() - first), first * sizeof(GLushort)};
         }
     }
 
-    Model *m = LoadDataToModel(vertices, normals, texCoords, NULL, indices, numVertices, numIndices);
-    return m;
+    // Attribute-less: the VAO only carries the element buffer
+    glGenVertexArrays(1, &clipmapVAO);
+    glBindVertexArray(clipmapVAO);
+    glGenBuffers(1, &clipmapEBO);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, clipmapEBO);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(GLushort), indices.data(), GL_STATIC_DRAW);
+    glBindVertexArray(0);
 }
 
 void Scene_InitModels()
 {
-    planeModel = CreateSubdividedPlane(500, 128.0f);
+    InitWaterClipmap();
+}
+
+void Scene_DrawWater(GLuint program, vec3 cameraPos)
+{
+    if (!clipmapVAO)
+        return;
+
+    glUseProgram(program);
+    glBindVertexArray(clipmapVAO);
+    glEnable(GL_PRIMITIVE_RESTART_FIXED_INDEX);
+    glUniform1i(glGetUniformLocation(program, "u_GridHalfCells"), kClipmapHalfCells);
+    GLint locOrigin = glGetUniformLocation(program, "u_LevelOrigin");
+    GLint locCell = glGetUniformLocation(program, "u_LevelCellSize");
+
+    // Each level's centre snaps to twice its cell size, so vertices only ever sit on that level's
+    // grid (no swimming) and the finer level's edge lands on this level's vertices.
+    int prevX = 0, prevZ = 0; // previous level's centre in this level's cells
+    for (int level = 0; level < kClipmapLevels; level++)
+    {
+        float cell = kClipmapCellSize * (float)(1 << level);
+        int cx = 2 * (int)floorf(cameraPos.x / (2.0f * cell) + 0.5f);
+        int cz = 2 * (int)floorf(cameraPos.z / (2.0f * cell) + 0.5f);
+        glUniform2f(locOrigin, cx * cell, cz * cell);
+        glUniform1f(locCell, cell);
+
+        const ClipmapRange &range = level == 0 ? clipmapFull : clipmapRings[prevZ - cz + 1][prevX - cx + 1];
+        glDrawElements(GL_TRIANGLE_STRIP, range.count, GL_UNSIGNED_SHORT, (const void *)range.offset);
+
+        prevX = cx / 2; // finer centres are multiples of two fine cells = one coarse cell
+        prevZ = cz / 2;
+    }
+    glDisable(GL_PRIMITIVE_RESTART_FIXED_INDEX);
+    glBindVertexArray(0);
 }
@@ -0,0 +1,225 @@
+#include "thread_pool.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Each worker owns a range of chunk indices packed into one 64-bit word:
+// [63:48] job tag, [47:24] begin, [23:0] end. The owner pops from the front and thieves
+// split off the back half with a CAS, so no locks are taken while a loop is running.
+// The tag makes CAS attempts from a thread still scanning a previous job fail. Workers join a
+// job under the mutex only while it is open, and ParallelFor closes it and waits for every
+// worker to leave participate() before it returns, so no thief outlives its job.
+static const int kRangeBits = 24;
+static const uint64_t kRangeMask = (1ull << kRangeBits) - 1;
+static const int kSpinIterations = 4096;
+
+static inline uint64_t packRange(uint64_t tag, uint64_t begin, uint64_t end)
+{
+    return (tag << (2 * kRangeBits)) | (begin << kRangeBits) | end;
+}
+
+static inline uint64_t rangeTag(uint64_t word) { return word >> (2 * kRangeBits); }
+static inline uint32_t rangeBegin(uint64_t word) { return static_cast<uint32_t>((word >> kRangeBits) & kRangeMask); }
+static inline uint32_t rangeEnd(uint64_t word) { return static_cast<uint32_t>(word & kRangeMask); }
+
+struct alignas(64) WorkerRange
+{
+    std::atomic<uint64_t> word{0};
+};
+
+struct ThreadPool
+{
+    int threadCount = 1;
+    std::vector<std::thread> threads;
+    std::vector<WorkerRange> ranges;
+
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::atomic<uint32_t> generation{0};
+    bool quit = false;
+    bool jobOpen = false;
+    std::atomic<int> activeWorkers{0};
+
+    // Current job, published before the ranges are stored.
+    const std::function<void(int, int, int)> *fn = nullptr;
+    int count = 0;
+    int grain = 1;
+    std::atomic<int> chunksLeft{0};
+};
+
+static void runChunk(ThreadPool *pool, uint32_t chunk, int worker)
+{
+    const int begin = static_cast<int>(chunk) * pool->grain;
+    const int end = begin + pool->grain < pool->count ? begin + pool->grain : pool->count;
+    (*pool->fn)(begin, end, worker);
+    pool->chunksLeft.fetch_sub(1, std::memory_order_acq_rel);
+}
+
+static bool popOwn(ThreadPool *pool, int worker, uint32_t &chunk)
+{
+    std::atomic<uint64_t> &slot = pool->ranges[worker].word;
+    uint64_t word = slot.load(std::memory_order_acquire);
+    while (rangeBegin(word) < rangeEnd(word))
+    {
+        uint64_t next = packRange(rangeTag(word), rangeBegin(word) + 1, rangeEnd(word));
+        if (slot.compare_exchange_weak(word, next, std::memory_order_acq_rel, std::memory_order_acquire))
+        {
+            chunk = rangeBegin(word);
+            return true;
+        }
+    }
+    return false;
+}
+
+// Moves the back half of some victim's range into the thief's own (empty) slot.
+static bool steal(ThreadPool *pool, int thief)
+{
+    for (int offset = 1; offset < pool->threadCount; ++offset)
+    {
+        const int victim = (thief + offset) % pool->threadCount;
+        std::atomic<uint64_t> &slot = pool->ranges[victim].word;
+        uint64_t word = slot.load(std::memory_order_acquire);
+        while (rangeBegin(word) < rangeEnd(word))
+        {
+            const uint32_t begin = rangeBegin(word);
+            const uint32_t end = rangeEnd(word);
+            const uint32_t mid = begin + (end - begin) / 2;
+            uint64_t kept = packRange(rangeTag(word), begin, mid);
+            if (slot.compare_exchange_weak(word, kept, std::memory_order_acq_rel, std::memory_order_acquire))
+            {
+                pool->ranges[thief].word.store(packRange(rangeTag(word), mid, end), std::memory_order_release);
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+static void participate(ThreadPool *pool, int worker)
+{
+    for (;;)
+    {
+        uint32_t chunk;
+        while (popOwn(pool, worker, chunk))
+            runChunk(pool, chunk, worker);
+        if (!steal(pool, worker))
+            return;
+    }
+}
+
+static void workerMain(ThreadPool *pool, int worker)
+{
+    uint32_t seen = 0;
+    for (;;)
+    {
+        int spins = 0;
+        while (pool->generation.load(std::memory_order_acquire) == seen && spins < kSpinIterations)
+        {
+            std::this_thread::yield();
+            ++spins;
+        }
+        {
+            std::unique_lock<std::mutex> lock(pool->mutex);
+            pool->wake.wait(lock, [&]
+            {
+                return pool->quit || pool->generation.load(std::memory_order_acquire) != seen;
+            });
+            if (pool->quit)
+                return;
+            seen = pool->generation.load(std::memory_order_acquire);
+            if (!pool->jobOpen)
+                continue;
+            pool->activeWorkers.fetch_add(1, std::memory_order_relaxed);
+        }
+        participate(pool, worker);
+        pool->activeWorkers.fetch_sub(1, std::memory_order_release);
+    }
+}
+
+ThreadPool *ThreadPool_Create(int threadCount)
+{
+    if (threadCount <= 0)
+        threadCount = static_cast<int>(std::thread::hardware_concurrency());
+    if (threadCount <= 0)
+        threadCount = 1;
+
+    ThreadPool *pool = new ThreadPool();
+    pool->threadCount = threadCount;
+    pool->ranges = std::vector<WorkerRange>(threadCount);
+    for (int worker = 1; worker < threadCount; ++worker)
+        pool->threads.emplace_back(workerMain, pool, worker);
+    return pool;
+}
+
+void ThreadPool_Destroy(ThreadPool *pool)
+{
+    if (!pool)
+        return;
+    {
+        std::lock_guard<std::mutex> lock(pool->mutex);
+        pool->quit = true;
+    }
+    pool->wake.notify_all();
+    for (std::thread &thread : pool->threads)
+        thread.join();
+    delete pool;
+}
+
+int ThreadPool_GetThreadCount(const ThreadPool *pool)
+{
+    return pool ? pool->threadCount : 1;
+}
+
+void ThreadPool_ParallelFor(ThreadPool *pool, int count, int grain,
+                            const std::function<void(int begin, int end, int worker)> &fn)
+{
+    if (count <= 0)
+        return;
+    if (grain < 1)
+        grain = 1;
+
+    const int chunks = (count + grain - 1) / grain;
+    if (!pool || pool->threadCount == 1 || chunks == 1 || chunks > static_cast<int>(kRangeMask))
+    {
+        fn(0, count, 0);
+        return;
+    }
+
+    pool->fn = &fn;
+    pool->count = count;
+    pool->grain = grain;
+    pool->chunksLeft.store(chunks, std::memory_order_relaxed);
+
+    const uint64_t tag = (pool->generation.load(std::memory_order_relaxed) + 1) & 0xFFFF;
+    const int threads = pool->threadCount;
+    for (int worker = 0; worker < threads; ++worker)
+    {
+        uint64_t begin = static_cast<uint64_t>(chunks) * worker / threads;
+        uint64_t end = static_cast<uint64_t>(chunks) * (worker + 1) / threads;
+        pool->ranges[worker].word.store(packRange(tag, begin, end), std::memory_order_release);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(pool->mutex);
+        pool->jobOpen = true;
+        pool->generation.fetch_add(1, std::memory_order_release);
+    }
+    pool->wake.notify_all();
+
+    participate(pool, 0);
+    while (pool->chunksLeft.load(std::memory_order_acquire) > 0)
+        std::this_thread::yield();
+
+    // A worker still scanning could otherwise steal from the next job's ranges and overwrite its
+    // own freshly published one.
+    {
+        std::lock_guard<std::mutex> lock(pool->mutex);
+        pool->jobOpen = false;
+    }
+    while (pool->activeWorkers.load(std::memory_order_acquire) > 0)
+        std::this_thread::yield();
+}